@@ -0,0 +1,51 @@
+#ifndef ARCHETYPE_H
+#define ARCHETYPE_H
+
+#include <godot_cpp/classes/ref.hpp>
+#include <godot_cpp/templates/hash_map.hpp>
+#include <godot_cpp/templates/local_vector.hpp>
+
+#include "component_mask.h"
+
+namespace godot {
+
+class Entity;
+class Component;
+
+// Table of every entity sharing one exact component set. Rows are dense:
+// entities[row] owns columns[c][row] for every component type c in the signature.
+class Archetype {
+public:
+    ComponentMask mask;
+    LocalVector<int> types;
+    // Indexed by component type ID, -1 when the type is not part of this archetype.
+    LocalVector<int> column_index;
+    LocalVector<Entity *> entities;
+    LocalVector<LocalVector<Ref<Component>>> columns;
+
+    HashMap<int, Archetype *> add_edges;
+    HashMap<int, Archetype *> remove_edges;
+
+    Archetype(const LocalVector<int> &p_sorted_types);
+
+    _FORCE_INLINE_ bool has_type(int p_type) const {
+        return mask.has(p_type);
+    }
+
+    _FORCE_INLINE_ int get_column(int p_type) const {
+        return (p_type >= 0 && uint32_t(p_type) < column_index.size()) ? column_index[p_type] : -1;
+    }
+
+    uint32_t size() const;
+
+    uint32_t add_row(Entity *p_entity);
+    void reserve(uint32_t p_additional);
+    Entity *remove_row(uint32_t p_row);
+
+    Ref<Component> get_component(uint32_t p_row, int p_type) const;
+    void set_component(uint32_t p_row, int p_column, const Ref<Component> &p_component);
+};
+
+}
+
+#endif // ARCHETYPE_H
@@ -0,0 +1,86 @@
+#ifndef COMMAND_BUFFER_H
+#define COMMAND_BUFFER_H
+
+#include <godot_cpp/classes/ref_counted.hpp>
+#include <godot_cpp/classes/resource.hpp>
+#include <godot_cpp/templates/local_vector.hpp>
+
+#include <mutex>
+
+namespace godot {
+
+class Entity;
+class Component;
+class Relationship;
+class World;
+
+// Records structural changes (components, entities, relationships) so they can
+// be applied together at a sync point instead of mid-iteration. Every System
+// owns one as `cmd`; the scheduler flushes it once the system's wave is done.
+//
+// flush() applies, in this order: entity additions, the net component changes
+// of each entity (the last add/remove per component type wins, and each entity
+// changes archetype once), relationship changes, then entity removals. Additions
+// and removals each go through the world's bulk path, and the component moves
+// update the query cache in one pass per world.
+//
+// Entities are added to the owning system's world, or the GECS world for a
+// buffer no system owns; everything else goes to the entity's own world.
+class CommandBuffer : public RefCounted {
+    GDCLASS(CommandBuffer, RefCounted)
+
+    friend class System;
+
+private:
+    enum CommandType {
+        ADD_ENTITY,
+        REMOVE_ENTITY,
+        ADD_COMPONENT,
+        REMOVE_COMPONENT,
+        ADD_RELATIONSHIP,
+        REMOVE_RELATIONSHIP,
+    };
+
+    struct Command {
+        CommandType type = ADD_ENTITY;
+        uint64_t entity = 0;
+        Ref<Resource> resource;
+    };
+
+    LocalVector<Command> commands;
+    std::mutex mutex;
+    uint64_t world_id = 0;
+
+    // Lanes let parallel chunks of one system record without locking. A lane is
+    // merged as its chunk finishes, or all in chunk order by _merge_lanes().
+    LocalVector<LocalVector<Command>> lanes;
+    static thread_local CommandBuffer *lane_buffer;
+    static thread_local uint32_t lane_index;
+
+    void _record(CommandType p_type, Entity *p_entity, const Ref<Resource> &p_resource = Ref<Resource>());
+    void _begin_lanes(uint32_t p_count);
+    void _merge_lane(uint32_t p_lane);
+    void _merge_lanes();
+    void _set_world(World *p_world);
+    World *_get_world() const;
+
+protected:
+    static void _bind_methods();
+
+public:
+    void add_entity(Entity *p_entity);
+    void remove_entity(Entity *p_entity);
+    void add_component(Entity *p_entity, const Ref<Component> &p_component);
+    void remove_component(Entity *p_entity, const Ref<Resource> &p_component);
+    void add_relationship(Entity *p_entity, const Ref<Relationship> &p_relationship);
+    void remove_relationship(Entity *p_entity, const Ref<Relationship> &p_relationship);
+
+    void flush();
+    void clear();
+    bool is_empty();
+    int size();
+};
+
+}
+
+#endif // COMMAND_BUFFER_H
@@ -4,11 +4,22 @@
 #include <godot_cpp/classes/resource.hpp>
 #include <godot_cpp/variant/dictionary.hpp>
 
+#include <atomic>
+
 namespace godot {
 
 class Component : public Resource {
     GDCLASS(Component, Resource)
 
+private:
+    // Cached from the registry; workers may resolve it concurrently.
+    mutable std::atomic<int> type_id{ -1 };
+    // Set on Prefab shared components: one instance referenced by many entities.
+    bool shared = false;
+    // World change ticks of the last add and the last property change.
+    uint64_t added_tick = 0;
+    uint64_t changed_tick = 0;
+
 protected:
     static void _bind_methods();
     
@@ -18,6 +29,13 @@ public:
     
     Dictionary serialize();
     bool equals(const Ref<Component> &other);
+    int get_type_id() const;
+    void _set_shared(bool p_shared);
+    bool is_shared() const;
+    void _mark_added(uint64_t p_tick);
+    void _mark_changed(uint64_t p_tick);
+    _FORCE_INLINE_ uint64_t _get_added_tick() const { return added_tick; }
+    _FORCE_INLINE_ uint64_t _get_changed_tick() const { return changed_tick; }
     
     void emit_property_changed(const String &property_name, const Variant &old_value, const Variant &new_value);
 };
@@ -0,0 +1,114 @@
+#ifndef COMPONENT_MASK_H
+#define COMPONENT_MASK_H
+
+#include <godot_cpp/core/defs.hpp>
+#include <godot_cpp/templates/hashfuncs.hpp>
+#include <godot_cpp/templates/local_vector.hpp>
+
+namespace godot {
+
+// Bitset of component type IDs (see GECS::get_component_type_id). Trailing zero
+// words are always trimmed so equal sets compare and hash equal.
+class ComponentMask {
+    LocalVector<uint64_t> words;
+
+    _FORCE_INLINE_ void _trim() {
+        while (!words.is_empty() && words[words.size() - 1] == 0) {
+            words.resize(words.size() - 1);
+        }
+    }
+
+public:
+    _FORCE_INLINE_ bool has(int p_id) const {
+        uint32_t word = uint32_t(p_id) >> 6;
+        return p_id >= 0 && word < words.size() && ((words[word] >> (p_id & 63)) & 1);
+    }
+
+    void set(int p_id) {
+        if (p_id < 0) return;
+        uint32_t word = uint32_t(p_id) >> 6;
+        while (words.size() <= word) {
+            words.push_back(0);
+        }
+        words[word] |= uint64_t(1) << (p_id & 63);
+    }
+
+    void unset(int p_id) {
+        uint32_t word = uint32_t(p_id) >> 6;
+        if (p_id < 0 || word >= words.size()) return;
+        words[word] &= ~(uint64_t(1) << (p_id & 63));
+        _trim();
+    }
+
+    void clear() {
+        words.clear();
+    }
+
+    _FORCE_INLINE_ bool is_empty() const {
+        return words.is_empty();
+    }
+
+    void merge(const ComponentMask &p_other) {
+        while (words.size() < p_other.words.size()) {
+            words.push_back(0);
+        }
+        for (uint32_t i = 0; i < p_other.words.size(); i++) {
+            words[i] |= p_other.words[i];
+        }
+    }
+
+    bool contains_all(const ComponentMask &p_other) const {
+        if (p_other.words.size() > words.size()) return false;
+        for (uint32_t i = 0; i < p_other.words.size(); i++) {
+            if ((words[i] & p_other.words[i]) != p_other.words[i]) return false;
+        }
+        return true;
+    }
+
+    bool intersects(const ComponentMask &p_other) const {
+        uint32_t count = MIN(words.size(), p_other.words.size());
+        for (uint32_t i = 0; i < count; i++) {
+            if (words[i] & p_other.words[i]) return true;
+        }
+        return false;
+    }
+
+    void get_ids(LocalVector<int> &r_ids) const {
+        for (uint32_t i = 0; i < words.size(); i++) {
+            uint64_t word = words[i];
+            for (int bit = 0; word != 0; bit++, word >>= 1) {
+                if (word & 1) {
+                    r_ids.push_back(int(i * 64) + bit);
+                }
+            }
+        }
+    }
+
+    bool operator==(const ComponentMask &p_other) const {
+        if (words.size() != p_other.words.size()) return false;
+        for (uint32_t i = 0; i < words.size(); i++) {
+            if (words[i] != p_other.words[i]) return false;
+        }
+        return true;
+    }
+
+    bool operator!=(const ComponentMask &p_other) const {
+        return !(*this == p_other);
+    }
+
+    uint32_t hash() const {
+        uint32_t h = HASH_MURMUR3_SEED;
+        for (uint32_t i = 0; i < words.size(); i++) {
+            h = hash_murmur3_one_64(words[i], h);
+        }
+        return hash_fmix32(h);
+    }
+
+    struct Hasher {
+        static _FORCE_INLINE_ uint32_t hash(const ComponentMask &p_mask) { return p_mask.hash(); }
+    };
+};
+
+}
+
+#endif // COMPONENT_MASK_H
@@ -0,0 +1,59 @@
+#ifndef COMPONENT_PREDICATE_H
+#define COMPONENT_PREDICATE_H
+
+#include <godot_cpp/variant/dictionary.hpp>
+#include <godot_cpp/variant/string_name.hpp>
+#include <godot_cpp/variant/variant.hpp>
+#include <godot_cpp/templates/local_vector.hpp>
+
+namespace godot {
+
+class Object;
+
+// Compiled form of a value query term such as {C_Health: {"hp": {"_lt": 20}}}.
+// Operators and operands are parsed once; evaluate() only reads properties.
+class ComponentPredicate {
+public:
+    enum Operator {
+        OP_EQ,
+        OP_NE,
+        OP_GT,
+        OP_LT,
+        OP_GTE,
+        OP_LTE,
+        OP_IN,
+        OP_NIN,
+    };
+
+    struct Test {
+        Operator op = OP_EQ;
+        Variant operand;
+        LocalVector<Variant> operands; // _in / _nin
+    };
+
+    struct PropertyTests {
+        StringName property;
+        LocalVector<Test> tests;
+    };
+
+    int type_id = -1;
+    LocalVector<PropertyTests> properties;
+
+    _FORCE_INLINE_ bool has_tests() const {
+        return !properties.is_empty();
+    }
+
+    void compile(int p_type_id, const Dictionary &p_query);
+    bool evaluate(const Object *p_component) const;
+
+    static bool parse_operator(const String &p_name, Operator &r_op);
+
+private:
+    static bool _equals(const Variant &p_a, const Variant &p_b);
+    static bool _compare(Variant::Operator p_op, const Variant &p_a, const Variant &p_b);
+    static bool _test(const Test &p_test, const Variant &p_value);
+};
+
+}
+
+#endif // COMPONENT_PREDICATE_H
@@ -0,0 +1,84 @@
+#ifndef DENSE_BITSET_H
+#define DENSE_BITSET_H
+
+#include <godot_cpp/core/defs.hpp>
+#include <godot_cpp/templates/local_vector.hpp>
+
+namespace godot {
+
+// Fixed-size bitset over dense indices (array positions, entity slots). The
+// whole-set operations are plain word loops the compiler can vectorize.
+class DenseBitset {
+    LocalVector<uint64_t> words;
+    uint32_t bit_count = 0;
+
+public:
+    void resize(uint32_t p_bits, bool p_value = false) {
+        bit_count = p_bits;
+        words.resize((p_bits + 63) >> 6);
+        uint64_t fill = p_value ? ~uint64_t(0) : 0;
+        for (uint32_t i = 0; i < words.size(); i++) {
+            words[i] = fill;
+        }
+        // Keep bits past the end clear so count() stays exact.
+        if (p_value && (p_bits & 63)) {
+            words[words.size() - 1] = (uint64_t(1) << (p_bits & 63)) - 1;
+        }
+    }
+
+    _FORCE_INLINE_ uint32_t size() const {
+        return bit_count;
+    }
+
+    _FORCE_INLINE_ bool has(uint32_t p_index) const {
+        return (words[p_index >> 6] >> (p_index & 63)) & 1;
+    }
+
+    _FORCE_INLINE_ void set(uint32_t p_index) {
+        words[p_index >> 6] |= uint64_t(1) << (p_index & 63);
+    }
+
+    _FORCE_INLINE_ void unset(uint32_t p_index) {
+        words[p_index >> 6] &= ~(uint64_t(1) << (p_index & 63));
+    }
+
+    void and_with(const DenseBitset &p_other) {
+        uint32_t count = MIN(words.size(), p_other.words.size());
+        for (uint32_t i = 0; i < count; i++) {
+            words[i] &= p_other.words[i];
+        }
+        for (uint32_t i = count; i < words.size(); i++) {
+            words[i] = 0;
+        }
+    }
+
+    void or_with(const DenseBitset &p_other) {
+        uint32_t count = MIN(words.size(), p_other.words.size());
+        for (uint32_t i = 0; i < count; i++) {
+            words[i] |= p_other.words[i];
+        }
+    }
+
+    void and_not(const DenseBitset &p_other) {
+        uint32_t count = MIN(words.size(), p_other.words.size());
+        for (uint32_t i = 0; i < count; i++) {
+            words[i] &= ~p_other.words[i];
+        }
+    }
+
+    uint32_t count() const {
+        uint32_t total = 0;
+        for (uint32_t i = 0; i < words.size(); i++) {
+            uint64_t word = words[i];
+            word = word - ((word >> 1) & 0x5555555555555555ULL);
+            word = (word & 0x3333333333333333ULL) + ((word >> 2) & 0x3333333333333333ULL);
+            word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+            total += uint32_t((word * 0x0101010101010101ULL) >> 56);
+        }
+        return total;
+    }
+};
+
+}
+
+#endif // DENSE_BITSET_H
@@ -5,28 +5,85 @@
 #include <godot_cpp/variant/dictionary.hpp>
 #include <godot_cpp/classes/script.hpp>
 #include <godot_cpp/variant/typed_array.hpp>
+#include <godot_cpp/templates/hash_map.hpp>
+#include <godot_cpp/core/gdvirtual.gen.inc>
+
+#include "component_mask.h"
+#include "entity_table.h"
 
 namespace godot {
 
 class Component;
 class Relationship;
+class World;
+class Archetype;
 
 class Entity : public Node {
     GDCLASS(Entity, Node)
 
+    friend class World;
+
 private:
     bool enabled = true;
-    Dictionary components;
+    // Set once the entity is initialized; virtual entities are initialized by the World, not by NOTIFICATION_READY.
+    bool initialized = false;
+    // Set once component_resources and define_components() have been instanced,
+    // or, for spawn_batch() copies, once the template's components were copied in.
+    bool components_defined = false;
+    // Only hold components while the entity is not attached to a World;
+    // attached entities live in a row of their World's archetype storage.
+    HashMap<int, Ref<Component>> components;
+    ComponentMask signature;
     Array relationships;
     TypedArray<Component> component_resources;
 
+    World *world = nullptr;
+    Archetype *archetype = nullptr;
+    uint32_t archetype_row = 0;
+    uint64_t handle = EntityTable::INVALID_HANDLE;
+
+    // Lifecycle hooks the attached script overrides, resolved once (see System).
+    enum ScriptOverride {
+        OVERRIDE_ON_READY = 1 << 0,
+        OVERRIDE_ON_UPDATE = 1 << 1,
+        OVERRIDE_ON_DESTROY = 1 << 2,
+        OVERRIDE_ON_DISABLE = 1 << 3,
+        OVERRIDE_ON_ENABLE = 1 << 4,
+        OVERRIDE_DEFINE_COMPONENTS = 1 << 5,
+        OVERRIDES_RESOLVED = 1 << 6,
+    };
+    uint32_t script_overrides = 0;
+
+    void _resolve_script_overrides();
+    _FORCE_INLINE_ bool _is_overridden(uint32_t p_override) {
+        if (!(script_overrides & OVERRIDES_RESOLVED)) {
+            _resolve_script_overrides();
+        }
+        return script_overrides & p_override;
+    }
+
     void _on_component_property_changed(Object *component, const StringName &property, const Variant &old_value, const Variant &new_value);
 
+    friend class CommandBuffer;
+    // Applies net per-type changes (a null component removes the type) with one archetype move.
+    void _apply_component_changes(const LocalVector<int> &p_types, const LocalVector<Ref<Component>> &p_components);
+    // The two halves of it: the archetype move, then the signals for what changed.
+    void _move_for_component_changes(const LocalVector<int> &p_types, const LocalVector<Ref<Component>> &p_components, LocalVector<Ref<Component>> &r_removed, LocalVector<Ref<Component>> &r_added);
+    void _announce_component_changes(const LocalVector<Ref<Component>> &p_removed, const LocalVector<Ref<Component>> &p_added);
+    void _remove_relationship_instance(const Ref<Relationship> &p_relationship);
+
 protected:
     static void _bind_methods();
     void _notification(int p_what);
     void _initialize();
 
+    GDVIRTUAL0(on_ready)
+    GDVIRTUAL1(on_update, double)
+    GDVIRTUAL0(on_destroy)
+    GDVIRTUAL0(on_disable)
+    GDVIRTUAL0(on_enable)
+    GDVIRTUAL0R(Array, define_components)
+
 public:
     Entity();
     ~Entity();
@@ -38,7 +95,13 @@ public:
     void remove_all_components();
     void deferred_remove_component(const Ref<Component> &p_component);
     Ref<Component> get_component(const Ref<Resource> &p_component_script) const;
+    Ref<Component> get_component_mut(const Ref<Resource> &p_component_script);
     bool has_component(const Ref<Resource> &p_component_script) const;
+    Array get_components() const;
+    Ref<Component> get_component_by_type_id(int p_type_id) const;
+    const ComponentMask &get_signature() const;
+    World *get_world() const;
+    int64_t get_handle() const;
     
     void add_relationship(const Ref<Relationship> &p_relationship);
     void add_relationships(const Array &p_relationships);
@@ -54,12 +117,12 @@ public:
     void set_enabled(bool p_enabled);
     bool is_enabled() const;
 
-    void on_ready();
-    void on_update(double delta);
-    void on_destroy();
-    void on_disable();
-    void on_enable();
-    Array define_components();
+    virtual void on_ready();
+    virtual void on_update(double delta);
+    virtual void on_destroy();
+    virtual void on_disable();
+    virtual void on_enable();
+    virtual Array define_components();
 };
 
 }
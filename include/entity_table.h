@@ -0,0 +1,71 @@
+#ifndef ENTITY_TABLE_H
+#define ENTITY_TABLE_H
+
+#include <godot_cpp/core/defs.hpp>
+#include <godot_cpp/templates/local_vector.hpp>
+
+namespace godot {
+
+class Entity;
+
+// Dense slot table of the entities attached to a World. A handle packs a
+// 32-bit slot index with that slot's generation; freeing a slot bumps its
+// generation, so handles to removed entities resolve to nullptr instead of a
+// dangling pointer. Live entities are kept packed for iteration, in an order
+// that depends only on the sequence of adds and removes.
+class EntityTable {
+public:
+    static const uint64_t INVALID_HANDLE = 0;
+
+    static _FORCE_INLINE_ uint32_t handle_index(uint64_t p_handle) {
+        return uint32_t(p_handle);
+    }
+
+    static _FORCE_INLINE_ uint32_t handle_generation(uint64_t p_handle) {
+        return uint32_t(p_handle >> 32);
+    }
+
+    uint64_t add(Entity *p_entity);
+    void reserve(uint32_t p_additional);
+    bool remove(uint64_t p_handle);
+    void clear();
+
+    _FORCE_INLINE_ Entity *get(uint64_t p_handle) const {
+        uint32_t index = handle_index(p_handle);
+        if (index >= slots.size() || slots[index].generation != handle_generation(p_handle)) {
+            return nullptr;
+        }
+        return slots[index].entity;
+    }
+
+    _FORCE_INLINE_ bool is_valid(uint64_t p_handle) const {
+        return get(p_handle) != nullptr;
+    }
+
+    _FORCE_INLINE_ uint32_t size() const {
+        return dense.size();
+    }
+
+    _FORCE_INLINE_ const LocalVector<Entity *> &get_entities() const {
+        return dense;
+    }
+
+private:
+    struct Slot {
+        Entity *entity = nullptr;
+        // Never 0, so a packed handle is never INVALID_HANDLE.
+        uint32_t generation = 1;
+        uint32_t dense_index = 0;
+    };
+
+    LocalVector<Slot> slots;
+    LocalVector<uint32_t> free_slots;
+    LocalVector<Entity *> dense;
+    LocalVector<uint32_t> dense_slots;
+
+    void _release(uint32_t p_index);
+};
+
+}
+
+#endif // ENTITY_TABLE_H
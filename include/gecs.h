@@ -6,12 +6,19 @@
 #include <godot_cpp/variant/dictionary.hpp>
 #include <godot_cpp/variant/callable.hpp>
 #include <godot_cpp/classes/script.hpp>
+#include <godot_cpp/templates/hash_map.hpp>
+#include <godot_cpp/templates/local_vector.hpp>
+
+#include <mutex>
+#include <shared_mutex>
 
 namespace godot {
 
 class World;
 class Entity;
 class Component;
+class QueryPlan;
+class ComponentTemplate;
 
 class GECS : public Node {
     GDCLASS(GECS, Node)
@@ -24,7 +31,31 @@ private:
     Array entity_preprocessors;
     Array entity_postprocessors;
 
+    // Component type registry. Every component script gets a dense integer ID
+    // the first time it is seen; lookups by script ObjectID skip String hashing.
+    // Systems on worker threads may look types up (and register new ones), so
+    // the registry is read under a shared lock and written under an exclusive one.
+    mutable std::shared_mutex component_types_mutex;
+    HashMap<uint64_t, int> component_type_ids;
+    HashMap<String, int> component_type_ids_by_path;
+    LocalVector<String> component_type_paths;
+
+    // Parsed QueryBuilder::compile() strings, shared by every builder. Systems
+    // compile on worker threads too; plans live until GECS is freed.
+    std::mutex query_plans_mutex;
+    HashMap<String, QueryPlan *> query_plans;
+
+    // Compiled component_resources entries, keyed by resource ObjectID. An entry
+    // is dropped when its resource reports a change (changed or property_changed);
+    // entries of freed resources are swept whenever the map doubles.
+    HashMap<uint64_t, ComponentTemplate *> component_templates;
+    uint32_t component_templates_sweep_size = 64;
+
     void _on_world_exited();
+    void _drop_component_template(uint64_t p_id);
+    void _on_component_template_changed(uint64_t p_id);
+    void _on_component_template_property_changed(Object *p_component, const String &p_property, const Variant &p_old_value, const Variant &p_new_value, uint64_t p_id);
+    int _register_component_type(Script *p_type);
 
 protected:
     static void _bind_methods();
@@ -50,6 +81,14 @@ public:
 
     Array get_components(const Array &entities, const Ref<Script> &component_type, const Ref<Component> &default_component = nullptr) const;
 
+    static int get_component_type_id(const Ref<Resource> &p_type);
+    static int get_component_type_id_for_object(Object *p_type);
+    static String get_component_type_path(int p_id);
+    static int get_component_type_count();
+
+    static const QueryPlan *get_query_plan(const String &p_query);
+    static const ComponentTemplate *get_component_template(const Ref<Component> &p_component);
+
     static Array intersect(const Array &array1, const Array &array2);
     static Array union_arrays(const Array &array1, const Array &array2);
     static Array difference(const Array &array1, const Array &array2);
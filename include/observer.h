@@ -17,6 +17,10 @@ protected:
     static void _bind_methods();
     Ref<QueryBuilder> q;
 
+    // Resolved once when the observer is added to a world.
+    Ref<QueryBuilder> match_query;
+    int watch_type_id = -1;
+
     GDVIRTUAL0R(Object*, match)
     GDVIRTUAL0R(Ref<Resource>, watch)
     GDVIRTUAL2(on_component_added, Entity*, Ref<Resource>)
@@ -29,6 +33,9 @@ public:
     
     void set_q(const Ref<QueryBuilder> &p_q);
 
+    int _resolve();
+    bool _matches(Entity *entity) const;
+
     virtual Ref<QueryBuilder> match();
     virtual Ref<Resource> watch();
     virtual void on_component_added(Entity *entity, Ref<Resource> component);
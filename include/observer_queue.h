@@ -0,0 +1,93 @@
+#ifndef OBSERVER_QUEUE_H
+#define OBSERVER_QUEUE_H
+
+#include <godot_cpp/core/defs.hpp>
+#include <godot_cpp/templates/hash_map.hpp>
+#include <godot_cpp/templates/hashfuncs.hpp>
+#include <godot_cpp/templates/local_vector.hpp>
+#include <godot_cpp/variant/string_name.hpp>
+#include <godot_cpp/variant/variant.hpp>
+
+#include "component.h"
+
+namespace godot {
+
+// FIFO of component events waiting for observers, stored in a power-of-two
+// ring that only grows. With coalescing on, a property change of an
+// (entity, component, property) that is still queued updates that event's
+// new value instead of queuing another, so it keeps the first old value and
+// the last new value at the position of the first change.
+class ObserverEventQueue {
+public:
+    enum EventType : uint8_t {
+        COMPONENT_ADDED,
+        COMPONENT_REMOVED,
+        COMPONENT_CHANGED,
+    };
+
+    struct Event {
+        EventType type = COMPONENT_ADDED;
+        uint64_t entity = 0; // Instance ID; the entity may be freed before dispatch.
+        Ref<Component> component;
+        StringName property;
+        Variant old_value;
+        Variant new_value;
+    };
+
+    explicit ObserverEventQueue(uint32_t p_capacity = 256);
+
+    void push(EventType p_type, uint64_t p_entity, Component *p_component);
+    void push_changed(uint64_t p_entity, Component *p_component, const StringName &p_property, const Variant &p_old_value, const Variant &p_new_value);
+    bool pop(Event &r_event);
+    void clear();
+
+    void set_coalescing(bool p_coalescing);
+
+    _FORCE_INLINE_ bool is_coalescing() const {
+        return coalescing;
+    }
+
+    _FORCE_INLINE_ uint32_t size() const {
+        return count;
+    }
+
+    _FORCE_INLINE_ bool is_empty() const {
+        return count == 0;
+    }
+
+private:
+    struct ChangeKey {
+        uint64_t entity = 0;
+        uint64_t component = 0;
+        StringName property;
+
+        bool operator==(const ChangeKey &p_other) const {
+            return entity == p_other.entity && component == p_other.component && property == p_other.property;
+        }
+
+        struct Hasher {
+            static uint32_t hash(const ChangeKey &p_key) {
+                uint32_t h = hash_murmur3_one_64(p_key.component, hash_murmur3_one_64(p_key.entity));
+                return hash_murmur3_one_32(p_key.property.hash(), h);
+            }
+        };
+    };
+
+    LocalVector<Event> ring;
+    // Sequence number of the oldest queued event; slot = sequence & (capacity - 1).
+    uint64_t head = 0;
+    uint32_t count = 0;
+    bool coalescing = false;
+    // Sequence number of the queued change event for each key, while coalescing.
+    HashMap<ChangeKey, uint64_t, ChangeKey::Hasher> pending_changes;
+
+    _FORCE_INLINE_ Event &_slot(uint64_t p_sequence) {
+        return ring[p_sequence & (ring.size() - 1)];
+    }
+
+    Event &_push_slot();
+};
+
+}
+
+#endif // OBSERVER_QUEUE_H
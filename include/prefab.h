@@ -0,0 +1,59 @@
+#ifndef PREFAB_H
+#define PREFAB_H
+
+#include <godot_cpp/classes/resource.hpp>
+#include <godot_cpp/classes/script.hpp>
+#include <godot_cpp/variant/typed_array.hpp>
+#include <godot_cpp/templates/local_vector.hpp>
+
+namespace godot {
+
+class Component;
+class Entity;
+
+// Compact copy of a component: its script plus only the script properties that
+// differ from a freshly constructed instance. Instancing runs the script constructor and
+// sets those few properties instead of walking the full property list the way
+// Resource::duplicate() does.
+class ComponentTemplate {
+public:
+    Ref<Script> script;
+    LocalVector<StringName> properties;
+    LocalVector<Variant> values;
+
+    bool build(const Ref<Component> &p_component);
+    Ref<Component> instantiate() const;
+};
+
+// A component set registered once and stamped onto many entities.
+// `components` are copied into every instance from their compiled templates;
+// `shared_components` are handed to every instance as the same object until an
+// entity asks for a writable copy through Entity.get_component_mut().
+class Prefab : public Resource {
+    GDCLASS(Prefab, Resource)
+
+private:
+    TypedArray<Component> components;
+    TypedArray<Component> shared_components;
+
+    LocalVector<ComponentTemplate> templates;
+    bool compiled = false;
+
+    void _compile();
+
+protected:
+    static void _bind_methods();
+
+public:
+    void set_components(const TypedArray<Component> &p_components);
+    TypedArray<Component> get_components() const;
+    void set_shared_components(const TypedArray<Component> &p_components);
+    TypedArray<Component> get_shared_components() const;
+
+    void add_component(const Ref<Component> &p_component, bool p_shared = false);
+    Entity *instantiate(Entity *p_entity = nullptr);
+};
+
+}
+
+#endif // PREFAB_H
@@ -0,0 +1,53 @@
+#ifndef PROPERTY_INDEX_H
+#define PROPERTY_INDEX_H
+
+#include <godot_cpp/variant/string_name.hpp>
+#include <godot_cpp/variant/variant.hpp>
+#include <godot_cpp/templates/hash_map.hpp>
+#include <godot_cpp/templates/local_vector.hpp>
+#include <godot_cpp/templates/rb_set.hpp>
+
+#include "component_predicate.h"
+
+namespace godot {
+
+class Entity;
+
+// Ordered index of one numeric component property (see World::create_property_index).
+// Entities whose value is not an int or float are simply left out.
+class PropertyIndex {
+public:
+    struct Entry {
+        double value = 0.0;
+        Entity *entity = nullptr;
+
+        bool operator<(const Entry &p_other) const {
+            return value < p_other.value || (value == p_other.value && entity < p_other.entity);
+        }
+    };
+
+    int type_id = -1;
+    StringName property;
+
+    PropertyIndex(int p_type_id, const StringName &p_property);
+
+    void set(Entity *p_entity, const Variant &p_value);
+    void erase(Entity *p_entity);
+    void clear();
+    uint32_t size() const;
+
+    // Appends every entity whose value can satisfy p_tests, narrowed by their
+    // range and equality operators. Returns false when none of the tests can
+    // use the index (e.g. only _ne or non-numeric operands).
+    bool collect(const LocalVector<ComponentPredicate::Test> &p_tests, LocalVector<Entity *> &r_entities) const;
+
+private:
+    RBSet<Entry> entries;
+    HashMap<Entity *, double> values;
+
+    void _collect_range(bool p_has_from, double p_from, bool p_from_inclusive, bool p_has_to, double p_to, bool p_to_inclusive, LocalVector<Entity *> &r_entities) const;
+};
+
+}
+
+#endif // PROPERTY_INDEX_H
@@ -4,13 +4,17 @@
 #include <godot_cpp/classes/ref_counted.hpp>
 #include <godot_cpp/variant/array.hpp>
 #include <godot_cpp/core/gdvirtual.gen.inc>
+#include <godot_cpp/templates/local_vector.hpp>
+
+#include "world.h"
+#include "component_predicate.h"
 
 namespace godot {
 
-class World;
 class Entity;
 class Component;
 class Relationship;
+class QueryPlan;
 
 class QueryBuilder : public RefCounted {
     GDCLASS(QueryBuilder, RefCounted)
@@ -22,15 +26,93 @@ private:
     Array none_components;
     Array relationships;
     Array exclude_relationships;
+    Array reverse_relationships;
     Array groups;
     Array exclude_groups;
     Array all_components_queries;
     Array any_components_queries;
+    Array changed_components;
+    Array added_components;
 
     bool cache_valid = false;
     Array cached_result;
+    // Version of the world's cached structural result that cached_result was filtered from.
+    uint64_t cached_version = 0;
+
+    uint64_t cached_property_version = 0;
+    uint64_t cached_relationship_version = 0;
+
+    // Compiled from the component arrays on first execute after they change.
+    bool query_key_valid = false;
+    World::QueryCacheKey query_key;
+    LocalVector<ComponentPredicate> all_predicates;
+    // Every with_any term, kept only when at least one of them tests values.
+    LocalVector<ComponentPredicate> any_predicates;
+    LocalVector<World::PropertyKey> watched_properties;
+    // A with_relationship()/without_relationship() entry resolved against the world's RelationshipIndex.
+    struct RelationshipTerm {
+        Ref<Relationship> relationship;
+        int type_id = -1;
+        uint64_t target = 0;
+        // An index hit alone settles the match: the relation has no properties
+        // to compare and the target isn't a script.
+        bool exact = false;
+    };
+    LocalVector<RelationshipTerm> relationship_terms;
+    LocalVector<RelationshipTerm> exclude_relationship_terms;
+    LocalVector<RelationshipTerm> reverse_relationship_terms;
+
+    // Compiled with_changed()/with_added() types, compared against change_since.
+    LocalVector<int> changed_type_ids;
+    LocalVector<int> added_type_ids;
+    uint64_t change_since = 0;
+
+    // Plan applied by the last compile(); recompiling the same string keeps the caches.
+    const QueryPlan *compiled_plan = nullptr;
+    // Set when compile() was given an invalid string; nothing matches until clear().
+    bool match_nothing = false;
+
+    void _apply_plan(const QueryPlan *p_plan);
+
+    void _compile_predicates(const Array &p_components, bool p_any, LocalVector<ComponentPredicate> &r_predicates);
+    uint64_t _get_property_version() const;
+    bool _matches_values(Entity *entity) const;
+    void _compile_relationships(const Array &p_relationships, LocalVector<RelationshipTerm> &r_terms);
+    bool _has_relationship(Entity *entity, const RelationshipTerm &p_term) const;
+    bool _is_relationship_target(Entity *entity, const RelationshipTerm &p_term) const;
+    bool _collect_relationship_targets(const RelationshipTerm &p_term, LocalVector<Entity *> *r_entities, int64_t &r_count) const;
+    bool _collect_relationship_sources(const RelationshipTerm &p_term, LocalVector<Entity *> *r_entities, int64_t &r_count) const;
+
+    enum QuerySource {
+        SOURCE_COMPONENTS,
+        SOURCE_PROPERTY_INDEX,
+        SOURCE_GROUPS,
+        SOURCE_RELATIONSHIP_INDEX,
+        SOURCE_REVERSE_RELATIONSHIP_INDEX,
+    };
+
+    enum QueryStageType {
+        STAGE_COMPONENTS,
+        STAGE_VALUES,
+        STAGE_GROUPS,
+        STAGE_EXCLUDE_GROUPS,
+        STAGE_RELATIONSHIPS,
+        STAGE_EXCLUDE_RELATIONSHIPS,
+        STAGE_CHANGES,
+        STAGE_REVERSE_RELATIONSHIPS,
+    };
+
+    // One filter step of an execution plan. Stages run most-selective-per-cost first.
+    struct QueryStage {
+        QueryStageType type = STAGE_COMPONENTS;
+        double selectivity = 1.0; // Estimated fraction of candidates kept.
+        double cost = 1.0; // Relative per-entity evaluation cost.
+        int64_t input = 0;
+        int64_t output = 0;
+    };
 
-    Array _internal_execute();
+    bool _passes_stage(QueryStageType p_type, Entity *entity) const;
+    Array _run_plan(const Array &p_structural, Dictionary *r_explain);
 
 protected:
     static void _bind_methods();
@@ -44,6 +126,9 @@ public:
     ~QueryBuilder();
 
     void _init(World* p_world);
+    const World::QueryCacheKey &_get_query_key();
+    bool _matches_entity(Entity *entity);
+    void _set_change_since(uint64_t p_tick);
 
     QueryBuilder* with_all(const Array &p_components);
     QueryBuilder* with_any(const Array &p_components);
@@ -53,6 +138,8 @@ public:
     QueryBuilder* with_group(const Array &p_groups);
     QueryBuilder* without_group(const Array &p_groups);
     QueryBuilder* with_reverse_relationship(const Array &p_relationships);
+    QueryBuilder* with_changed(const Array &p_components);
+    QueryBuilder* with_added(const Array &p_components);
     
     QueryBuilder* clear();
     virtual Ref<QueryBuilder> combine(const Ref<QueryBuilder> &other);
@@ -65,6 +152,7 @@ public:
     bool is_empty() const;
     Array as_array() const;
     QueryBuilder* compile(const String &query);
+    Dictionary explain();
 };
 
 }
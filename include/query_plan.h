@@ -0,0 +1,48 @@
+#ifndef QUERY_PLAN_H
+#define QUERY_PLAN_H
+
+#include <godot_cpp/variant/array.hpp>
+#include <godot_cpp/variant/string.hpp>
+#include <godot_cpp/classes/resource.hpp>
+#include <godot_cpp/templates/local_vector.hpp>
+
+namespace godot {
+
+// Parsed form of a QueryBuilder::compile() string. Plans are immutable once
+// parsed and shared through GECS::get_query_plan(), so each distinct string is
+// parsed once per run.
+//
+// Grammar (whitespace is insignificant, clause names may drop the with_ prefix):
+//   query  := clause*
+//   clause := with_all(components) | with_any(components) | with_none(components)
+//           | with_group(names) | without_group(names)
+//           | with_relationship(relations) | without_relationship(relations)
+//   component := type [ '{' property op value (',' property op value)* '}' ]
+//   relation  := type [ ':' (type | '*') ]
+//   type      := global class name | "res://path.gd"
+//   op        := == | != | > | < | >= | <= | in | nin
+//   value     := number | "string" | true | false | null | '[' value, ... ']'
+//
+// Example: with_all(C_Health{hp < 20}, C_Velocity) without_group(dead) with_relationship(R_Targets:*)
+class QueryPlan {
+public:
+    bool valid = false;
+    String error;
+
+    Array all_components;
+    Array any_components;
+    Array none_components;
+    Array relationships;
+    Array exclude_relationships;
+    Array groups;
+    Array exclude_groups;
+
+    // Scripts used as relationship targets are referenced by raw pointer.
+    LocalVector<Ref<Resource>> resources;
+
+    static QueryPlan *parse(const String &p_query);
+};
+
+}
+
+#endif // QUERY_PLAN_H
@@ -13,8 +13,9 @@ class Relationship : public Resource {
 
 private:
     Ref<Component> relation;
-    Object* target;
-    Object* source;
+    // Instance IDs, so a freed target or source reads back as null instead of dangling.
+    uint64_t target_id = 0;
+    uint64_t source_id = 0;
 
 protected:
     static void _bind_methods();
@@ -31,6 +32,7 @@ public:
     
     bool matches(const Ref<Relationship> &other, bool weak = false) const;
     bool is_valid() const;
+    _FORCE_INLINE_ uint64_t _get_target_id() const { return target_id; }
 
     void set_relation(const Ref<Component> &p_relation);
     Ref<Component> get_relation() const;
@@ -0,0 +1,139 @@
+#ifndef RELATIONSHIP_INDEX_H
+#define RELATIONSHIP_INDEX_H
+
+#include <godot_cpp/templates/hash_map.hpp>
+#include <godot_cpp/templates/hashfuncs.hpp>
+#include <godot_cpp/templates/local_vector.hpp>
+
+#include "relationship.h"
+
+namespace godot {
+
+class Entity;
+
+// Source entities of every relationship attached in a World, by relation type
+// and by (relation type, target). Counts allow one source to hold several
+// relationships under the same key.
+//
+// Targets are keyed by instance ID. Relationships whose target is null or a
+// Script can match many targets, so they are filed under target 0; ones with
+// a null relation can match any type and are only kept in `untyped`.
+//
+// The reverse side records, per relation type (-1 for null relations), which
+// entities and which entity scripts are relationship targets, and keeps the
+// relationships pointing at each target entity.
+class RelationshipIndex {
+public:
+    typedef HashMap<Entity *, uint32_t> SourceSet;
+    typedef HashMap<uint64_t, uint32_t> TargetSet;
+
+    struct Targets {
+        TargetSet entities;
+        TargetSet scripts;
+    };
+
+    // One relationship instance may be attached to several sources.
+    struct Reference {
+        uint64_t source = 0;
+        Relationship *relationship = nullptr;
+    };
+
+    static int relation_type(const Ref<Relationship> &p_relationship);
+    static uint64_t target_key(const Ref<Relationship> &p_relationship);
+
+    void add(Entity *p_source, const Ref<Relationship> &p_relationship);
+    void remove(Entity *p_source, const Ref<Relationship> &p_relationship);
+    void clear();
+
+    // Sources with a relationship of this type, to p_target when it isn't 0.
+    const SourceSet *get_sources(int p_type_id, uint64_t p_target = 0) const;
+    _FORCE_INLINE_ const SourceSet &get_untyped() const {
+        return untyped;
+    }
+
+    // Targets of relationships of this type, or of any type when p_type_id is -1.
+    const Targets *get_targets(int p_type_id) const;
+    // Targets of relationships with a null relation, which match every type.
+    const Targets *get_untyped_targets() const;
+    // Indexed relationships whose target is this entity, for cleanup when it goes away.
+    const LocalVector<Reference> *get_referencing(uint64_t p_target) const;
+    bool is_target(int p_type_id, uint64_t p_entity, uint64_t p_script) const;
+
+    _FORCE_INLINE_ bool has(int p_type_id, Entity *p_source) const {
+        return uint32_t(p_type_id) < by_type.size() && by_type[p_type_id].has(p_source);
+    }
+
+    _FORCE_INLINE_ bool has(int p_type_id, uint64_t p_target, Entity *p_source) const {
+        const SourceSet *sources = by_target.getptr(TargetKey(p_type_id, p_target));
+        return sources && sources->has(p_source);
+    }
+
+private:
+    struct TargetKey {
+        int type_id = -1;
+        uint64_t target = 0;
+
+        TargetKey() {}
+        TargetKey(int p_type_id, uint64_t p_target) : type_id(p_type_id), target(p_target) {}
+
+        bool operator==(const TargetKey &p_other) const {
+            return type_id == p_other.type_id && target == p_other.target;
+        }
+
+        struct Hasher {
+            static uint32_t hash(const TargetKey &p_key) {
+                return hash_murmur3_one_64(p_key.target, hash_murmur3_one_32(p_key.type_id));
+            }
+        };
+    };
+
+    LocalVector<SourceSet> by_type;
+    HashMap<TargetKey, SourceSet, TargetKey::Hasher> by_target;
+    SourceSet untyped;
+
+    // The key each relationship was filed under, so removal never looks at a
+    // target that may have been freed or reassigned since.
+    HashMap<int, Targets> targets_by_type;
+    Targets all_targets;
+    HashMap<uint64_t, LocalVector<Reference>> referencing;
+
+    // Filed per (source, relationship): the same instance added to two
+    // entities is two entries.
+    struct FiledKey {
+        const Relationship *relationship = nullptr;
+        uint64_t source = 0;
+
+        FiledKey() {}
+        FiledKey(const Relationship *p_relationship, uint64_t p_source) : relationship(p_relationship), source(p_source) {}
+
+        bool operator==(const FiledKey &p_other) const {
+            return relationship == p_other.relationship && source == p_other.source;
+        }
+
+        struct Hasher {
+            static uint32_t hash(const FiledKey &p_key) {
+                return hash_murmur3_one_64(p_key.source, hash_murmur3_one_64(uint64_t(p_key.relationship)));
+            }
+        };
+    };
+
+    struct Filed {
+        TargetKey key;
+        uint64_t target = 0;
+        bool script_target = false;
+        uint32_t count = 0;
+    };
+    HashMap<FiledKey, Filed, FiledKey::Hasher> filed;
+
+    static void _add_target(Targets &r_targets, const Filed &p_filed);
+    static void _remove_target(Targets &r_targets, const Filed &p_filed);
+
+    template <typename K>
+    static void _increment(HashMap<K, uint32_t> &r_set, const K &p_key);
+    template <typename K>
+    static bool _decrement(HashMap<K, uint32_t> &r_set, const K &p_key);
+};
+
+}
+
+#endif // RELATIONSHIP_INDEX_H
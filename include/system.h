@@ -4,11 +4,20 @@
 #include <godot_cpp/classes/node.hpp>
 #include <godot_cpp/variant/dictionary.hpp>
 #include <godot_cpp/variant/array.hpp>
+#include <godot_cpp/variant/callable.hpp>
+#include <godot_cpp/core/gdvirtual.gen.inc>
+#include <godot_cpp/templates/local_vector.hpp>
+
+#include <mutex>
+
+#include "command_buffer.h"
+#include "component_mask.h"
+#include "query_builder.h"
 
 namespace godot {
 
-class QueryBuilder;
 class Entity;
+class World;
 
 class System : public Node {
     GDCLASS(System, Node)
@@ -22,20 +31,120 @@ public:
 protected:
     static void _bind_methods();
     void _notification(int p_what);
+
+    GDVIRTUAL0R(Dictionary, deps)
+    GDVIRTUAL0R(Ref<QueryBuilder>, query)
+    GDVIRTUAL0R(Array, sub_systems)
+    GDVIRTUAL0(setup)
+    GDVIRTUAL2(process, Entity *, double)
+    GDVIRTUAL2R(bool, process_all, const Array &, double)
+    GDVIRTUAL3(process_batch, const Array &, const Dictionary &, double)
     
 private:
+    // Which hooks the attached script overrides. Resolved once, then per-entity
+    // calls skip the lookup entirely when a hook isn't overridden.
+    enum ScriptOverride {
+        OVERRIDE_DEPS = 1 << 0,
+        OVERRIDE_QUERY = 1 << 1,
+        OVERRIDE_SUB_SYSTEMS = 1 << 2,
+        OVERRIDE_SETUP = 1 << 3,
+        OVERRIDE_PROCESS = 1 << 4,
+        OVERRIDE_PROCESS_ALL = 1 << 5,
+        OVERRIDE_PROCESS_BATCH = 1 << 6,
+        OVERRIDES_RESOLVED = 1 << 7,
+    };
+    uint32_t script_overrides = 0;
+
+    void _resolve_script_overrides();
+    _FORCE_INLINE_ bool _is_overridden(uint32_t p_override) {
+        if (!(script_overrides & OVERRIDES_RESOLVED)) {
+            _resolve_script_overrides();
+        }
+        return script_overrides & p_override;
+    }
+
     String group;
     bool process_empty = false;
     bool active = true;
     int order = 0;
     bool paused = false;
     Ref<QueryBuilder> q;
+    // Structural changes recorded during process(), flushed after the system's wave.
+    Ref<CommandBuffer> cmd;
+    // The world that added this system; the GECS world until one does.
+    uint64_t world_id = 0;
+
+    // Component access declarations used by SystemScheduler.
+    bool thread_safe = false;
+    Array reads;
+    Array writes;
+    ComponentMask read_mask;
+    ComponentMask write_mask;
+
+    // Work staged by the scheduler for the current frame.
+    Ref<QueryBuilder> pending_query;
+    Array pending_entities;
+    LocalVector<Array> pending_sub_entities;
+    double pending_delta = 0.0;
+    // Structural calls made on a worker thread, replayed at the wave's sync point.
+    LocalVector<Callable> deferred_calls;
+    // World change ticks of this frame's run and of the previous one, see with_changed().
+    uint64_t run_tick = 0;
+    uint64_t last_run_tick = 0;
+
+    // Chunked iteration of the default process_all(), see _process_parallel().
+    // Only thread_safe systems are chunked, since process() and on_update(),
+    // script overrides included, then run on pool threads.
+    bool parallel = false;
+    int grain_size = 64;
+    // Replay chunk structural changes in chunk order instead of completion order.
+    bool deterministic = false;
+    Array chunk_entities;
+    double chunk_delta = 0.0;
+    LocalVector<LocalVector<Callable>> chunk_calls;
+    LocalVector<uint32_t> chunk_order;
+    std::mutex chunk_mutex;
+
+    // Component properties handed to process_batch() as packed columns.
+    struct BatchColumn {
+        StringName name;
+        int type_id = -1;
+        StringName property;
+    };
+    Dictionary batch_columns;
+    LocalVector<BatchColumn> batch_column_specs;
+    bool batch_columns_dirty = true;
+
+    // sub_systems() pairs, fetched once. Each keeps its own QueryBuilder so its
+    // cached result survives between frames until the world invalidates it.
+    struct SubSystem {
+        Ref<QueryBuilder> query;
+        Callable callable;
+    };
+    LocalVector<SubSystem> sub_system_list;
+    bool sub_systems_resolved = false;
+
+    void _resolve_sub_systems();
+    void _run_sub_systems();
+    void _process_parallel(const Array &entities, double delta);
+    void _process_chunk(uint32_t p_chunk);
+    void _process_range(const Array &entities, int64_t begin, int64_t end, double delta);
+    void _process_batch(const Array &entities, double delta);
+    void _compile_batch_columns();
 
 public:
     System();
     ~System();
     
     void _handle(double delta);
+    bool _declare_access();
+    bool _conflicts_with(const System *p_other) const;
+    void _prepare_entities(double delta);
+    void _run();
+    void _run_task();
+    void _sync();
+    void _set_world(World *p_world);
+    World *_get_world() const;
     
     void set_group(const String &p_group);
     String get_group() const;
@@ -47,16 +156,32 @@ public:
     int get_order() const;
     void set_paused(bool p_paused);
     bool get_paused() const;
+    void set_thread_safe(bool p_thread_safe);
+    bool is_thread_safe() const;
+    void set_reads(const Array &p_reads);
+    Array get_reads() const;
+    void set_writes(const Array &p_writes);
+    Array get_writes() const;
+    void set_parallel(bool p_parallel);
+    bool is_parallel() const;
+    void set_grain_size(int p_grain_size);
+    int get_grain_size() const;
+    void set_deterministic(bool p_deterministic);
+    bool is_deterministic() const;
+    void set_batch_columns(const Dictionary &p_columns);
+    Dictionary get_batch_columns() const;
     
     void set_q(const Ref<QueryBuilder> &p_q);
     Ref<QueryBuilder> get_q();
+    Ref<CommandBuffer> get_cmd() const;
 
-    Dictionary deps();
-    Ref<QueryBuilder> query();
-    Array sub_systems();
-    void setup();
-    void process(Entity *entity, double delta);
-    bool process_all(const Array &entities, double delta);
+    // Native systems override these directly; the defaults forward to script overrides.
+    virtual Dictionary deps();
+    virtual Ref<QueryBuilder> query();
+    virtual Array sub_systems();
+    virtual void setup();
+    virtual void process(Entity *entity, double delta);
+    virtual bool process_all(const Array &entities, double delta);
 };
 
 }
@@ -0,0 +1,47 @@
+#ifndef SYSTEM_SCHEDULER_H
+#define SYSTEM_SCHEDULER_H
+
+#include <godot_cpp/variant/array.hpp>
+#include <godot_cpp/variant/callable.hpp>
+#include <godot_cpp/variant/dictionary.hpp>
+#include <godot_cpp/templates/local_vector.hpp>
+
+namespace godot {
+
+class System;
+
+// Runs one group's systems in waves. A system goes to a later wave than every
+// earlier system (in GECS::topological_sort order) that it conflicts with:
+// one writes a component type the other reads or writes, deps() links them,
+// or either is not thread_safe. Systems sharing a wave run on the
+// WorkerThreadPool; queries are executed on the main thread just before each
+// wave, so every system still sees the structural changes of earlier waves.
+// Once a wave has finished, each system's deferred structural calls are
+// replayed and its CommandBuffer flushed, in system order.
+class SystemScheduler {
+    friend class System;
+
+    static thread_local bool worker_thread;
+    // When set, defer_call() collects into it instead of queueing on the main thread.
+    static thread_local LocalVector<Callable> *deferred_calls;
+
+    LocalVector<System *> systems;
+    LocalVector<Dictionary> system_deps;
+    LocalVector<uint32_t> waves;
+    LocalVector<int64_t> tasks;
+
+    static bool _depends_on(const Dictionary &p_deps, System *p_other);
+
+public:
+    // With p_multithreaded false every system runs serially on the calling thread.
+    void run(const Array &p_systems, double p_delta, bool p_multithreaded);
+
+    // True while a system runs on a worker thread. Structural changes made there
+    // are deferred to the main thread.
+    static bool is_worker_thread();
+    static void defer_call(const Callable &p_call);
+};
+
+}
+
+#endif // SYSTEM_SCHEDULER_H
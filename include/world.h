@@ -5,6 +5,18 @@
 #include <godot_cpp/variant/dictionary.hpp>
 #include <godot_cpp/variant/node_path.hpp>
 #include <godot_cpp/core/gdvirtual.gen.inc>
+#include <godot_cpp/templates/hash_map.hpp>
+#include <godot_cpp/templates/local_vector.hpp>
+
+#include <atomic>
+#include <mutex>
+
+#include "component_mask.h"
+#include "component_predicate.h"
+#include "entity_table.h"
+#include "observer_queue.h"
+#include "relationship_index.h"
+#include "system_scheduler.h"
 
 namespace godot {
 
@@ -14,30 +26,135 @@ class Observer;
 class QueryBuilder;
 class Component;
 class Relationship;
+class Archetype;
+class PropertyIndex;
 
 class World : public Node {
     GDCLASS(World, Node)
 
+    friend class Entity;
+    friend class CommandBuffer;
+
+public:
+    struct QueryCacheKey {
+        ComponentMask all;
+        ComponentMask any;
+        ComponentMask none;
+        // Set when with_any was given, even if none of its types are registered yet.
+        bool any_filter = false;
+
+        _FORCE_INLINE_ bool matches(const ComponentMask &p_mask) const {
+            return p_mask.contains_all(all) && (!any_filter || p_mask.intersects(any)) && !p_mask.intersects(none);
+        }
+
+        bool operator==(const QueryCacheKey &p_other) const {
+            return any_filter == p_other.any_filter && all == p_other.all && any == p_other.any && none == p_other.none;
+        }
+
+        struct Hasher {
+            static uint32_t hash(const QueryCacheKey &p_key) {
+                uint32_t h = hash_murmur3_one_32(p_key.none.hash(), hash_murmur3_one_32(p_key.any.hash(), p_key.all.hash()));
+                return hash_murmur3_one_32(p_key.any_filter, h);
+            }
+        };
+    };
+
+    // A component property referenced by a value-based query.
+    struct PropertyKey {
+        int type_id = -1;
+        StringName property;
+
+        bool operator==(const PropertyKey &p_other) const {
+            return type_id == p_other.type_id && property == p_other.property;
+        }
+
+        struct Hasher {
+            static uint32_t hash(const PropertyKey &p_key) {
+                return hash_murmur3_one_32(p_key.property.hash(), hash_murmur3_one_32(p_key.type_id));
+            }
+        };
+    };
+
+    enum InvalidationCause {
+        INVALIDATION_ENTITY_ADDED,
+        INVALIDATION_ENTITY_REMOVED,
+        INVALIDATION_COMPONENT_ADDED,
+        INVALIDATION_COMPONENT_REMOVED,
+        INVALIDATION_PROPERTY_CHANGED,
+        INVALIDATION_MAX,
+    };
+
 private:
-    Dictionary entities;
+    EntityTable entities;
+    // Snapshot handed out by get_entities(), rebuilt after the table changes.
+    Array entity_list;
+    bool entity_list_dirty = true;
     Dictionary systems_by_group;
-    Dictionary component_entity_index;
+    SystemScheduler scheduler;
+    bool multithreaded = true;
+    // Guards state that systems running on worker threads may touch: the query
+    // cache, property versions and indexes, and the observer queue.
+    mutable std::mutex _sync_mutex;
+
+    // Archetype storage: every attached entity lives in exactly one table,
+    // keyed by its component mask.
+    HashMap<ComponentMask, Archetype *, ComponentMask::Hasher> archetypes;
+    LocalVector<Archetype *> archetype_list;
+    // Indexed by component type ID: every archetype containing that type.
+    LocalVector<LocalVector<Archetype *>> component_archetype_index;
     
     Array observers;
-    Array _observer_queue;
+    // Indexed by watched component type ID: instance IDs of the observers watching it.
+    LocalVector<LocalVector<uint64_t>> observer_type_index;
+    ObserverEventQueue _observer_queue;
     bool _processing_observers = false;
 
     NodePath entity_nodes_root;
     NodePath system_nodes_root;
 
-    Dictionary _query_result_cache;
+    // A structural query result kept in sync with signature changes one entity
+    // at a time. Once result has been handed out it is copied before the next
+    // mutation, so callers always hold a stable snapshot.
+    struct CachedQuery;
+
+    HashMap<QueryCacheKey, CachedQuery *, QueryCacheKey::Hasher> _query_result_cache;
+    LocalVector<CachedQuery *> _cached_queries;
+    // Indexed by component type ID: cached queries whose all/any/none sets mention that type.
+    LocalVector<LocalVector<CachedQuery *>> _cached_queries_by_type;
+    uint64_t _query_version = 0;
+    // Only properties some value query watches are tracked; other changes cost one lookup.
+    HashMap<PropertyKey, uint64_t, PropertyKey::Hasher> _property_versions;
+    uint64_t _invalidations[INVALIDATION_MAX] = {};
+    // Causes of structural cache updates not yet announced through cache_invalidated.
+    uint32_t _pending_invalidations = 0;
+
+    // Archetype moves held back by _begin_move_batch(); the query cache catches
+    // up on all of them in one pass at _end_move_batch().
+    struct PendingMove {
+        Entity *entity = nullptr;
+        Archetype *source = nullptr;
+        Archetype *target = nullptr;
+        InvalidationCause cause = INVALIDATION_COMPONENT_ADDED;
+    };
+    LocalVector<PendingMove> _pending_moves;
+    bool _batching_moves = false;
+
+    // Opt-in ordered indexes for value queries, see create_property_index().
+    HashMap<PropertyKey, PropertyIndex *, PropertyKey::Hasher> _property_indexes;
+    LocalVector<LocalVector<PropertyIndex *>> _property_indexes_by_type;
+
+    // Relationship sources of attached entities, kept from relationship_added/removed.
+    RelationshipIndex _relationship_index;
+    uint64_t _relationship_version = 0;
 
-    // Add public access to reverse_relationship_index for QueryBuilder
 public:
-    Dictionary relationship_entity_index;
-    Dictionary reverse_relationship_index; // Made public for QueryBuilder access
+    // Change detection. Each system run takes the next tick; components record
+    // the tick of the run (or, outside systems, the upcoming tick) that added or
+    // changed them, so with_changed()/with_added() compare against a system's last run.
+    static thread_local uint64_t system_tick;
 
 private:
+    std::atomic<uint64_t> _change_tick{1};
     int _cache_hits = 0;
     int _cache_misses = 0;
 
@@ -50,9 +167,12 @@ public:
     ~World();
 
     void initialize();
-    void add_entity(Entity *entity);
+    void add_entity(Entity *entity, const Variant &components = Variant(), bool add_to_tree = true);
     void add_entities(const Array &p_entities);
+    Array spawn_batch(Object *p_template, int p_count, bool add_to_tree = true);
+    void promote_entity(Entity *entity);
     void remove_entity(Entity *entity);
+    void remove_entities(const Array &p_entities);
     void disable_entity(Entity *entity);
     void enable_entity(Entity *entity);
 
@@ -66,10 +186,34 @@ public:
 
     void purge(bool should_free = true);
 
+    void create_property_index(const Ref<Resource> &p_component, const StringName &p_property);
+    void remove_property_index(const Ref<Resource> &p_component, const StringName &p_property);
+    bool has_property_index(const Ref<Resource> &p_component, const StringName &p_property) const;
+    bool _collect_property_index(const PropertyKey &p_key, const LocalVector<ComponentPredicate::Test> &p_tests, LocalVector<Entity *> &r_entities, uint32_t &r_index_size) const;
+
+    Array get_entities();
+    int get_entity_count() const;
+    bool has_entity(Entity *entity) const;
+    Entity *get_entity(int64_t p_handle) const;
+    bool is_entity_handle_valid(int64_t p_handle) const;
+
     void process(double delta, const String &group = "");
+    void set_multithreaded(bool p_multithreaded);
+    bool is_multithreaded() const;
+    void set_observer_coalescing(bool p_coalescing);
+    bool is_observer_coalescing() const;
     
     Ref<QueryBuilder> get_query();
     Array _query(const Array &all, const Array &any, const Array &none);
+    Array _query(const QueryCacheKey &p_key, uint64_t *r_version = nullptr);
+    void _query_archetypes(const Array &all, const Array &any, const Array &none, LocalVector<Archetype *> &r_archetypes);
+    static void _make_query_key(const Array &all, const Array &any, const Array &none, QueryCacheKey &r_key);
+    uint64_t _watch_property(const PropertyKey &p_key);
+    uint64_t _get_property_version(const PropertyKey &p_key) const;
+    _FORCE_INLINE_ const RelationshipIndex &_get_relationship_index() const { return _relationship_index; }
+    _FORCE_INLINE_ uint64_t _get_relationship_version() const { return _relationship_version; }
+    uint64_t _next_change_tick();
+    uint64_t _get_change_tick() const;
 
     void set_entity_nodes_root(const NodePath &p_path);
     NodePath get_entity_nodes_root() const;
@@ -81,15 +225,51 @@ public:
     void reset_cache_stats();
 
 private:
-    String _generate_query_cache_key(const Array &all, const Array &any, const Array &none);
-    void _add_entity_to_index(Entity *entity, const String &component_path);
-    void _remove_entity_from_index(Entity *entity, const String &component_path);
+    static bool _build_component_mask(const Array &p_components, ComponentMask &r_mask);
+    void _query_archetypes(const QueryCacheKey &p_key, LocalVector<Archetype *> &r_archetypes);
+
+    void _cache_insert(CachedQuery *p_query, Entity *entity, InvalidationCause p_cause);
+    void _cache_erase(CachedQuery *p_query, Entity *entity, InvalidationCause p_cause);
+    void _cache_add_entity(Entity *entity);
+    void _cache_remove_entity(Entity *entity);
+    void _cache_batch(const LocalVector<Entity *> &p_entities, bool p_added);
+    void _cache_update_entity(Entity *entity, int type_id, const ComponentMask &p_old_mask, const ComponentMask &p_new_mask);
+    void _clear_query_cache();
+    void _emit_cache_invalidated();
+
+    Archetype *_get_or_create_archetype(const LocalVector<int> &p_sorted_types);
+    Archetype *_archetype_with(Archetype *p_archetype, int p_type_id);
+    Archetype *_archetype_without(Archetype *p_archetype, int p_type_id);
+    void _move_entity(Entity *entity, Archetype *p_target);
+    Archetype *_detached_archetype(Entity *entity);
+    void _attach_entity(Entity *entity);
+    void _store_entity(Entity *entity, Archetype *archetype);
+    void _detach_entity(Entity *entity, bool p_update_cache = true);
+    void _place_entity(Entity *entity, Node *p_root);
+    void _add_entities(const LocalVector<Entity *> &p_entities, bool p_emit_each, bool p_add_to_tree);
+    void _restore_detached_components(Entity *entity);
+    void _set_entity_component(Entity *entity, int type_id, const Ref<Component> &component);
+    void _erase_entity_component(Entity *entity, int type_id);
+    void _apply_component_changes(Entity *entity, const LocalVector<int> &p_added_types, const LocalVector<Ref<Component>> &p_added, const LocalVector<int> &p_removed_types);
+    void _begin_move_batch();
+    void _end_move_batch();
+    void _clear_storage();
+
+    void _mark_added(const Ref<Component> &component);
+    void _index_component(Entity *entity, int type_id, const Ref<Component> &component);
+    void _unindex_component(Entity *entity, int type_id);
+    void _clear_property_indexes();
+    void _on_component_value_changed(Entity *entity, Component *component, const StringName &property, const Variant &new_value);
 
     void _on_entity_component_added(Object *entity, Object *component);
     void _on_entity_component_removed(Object *entity, Object *component);
     void _on_entity_component_property_changed(Object *entity, Object *component, const StringName &property, const Variant &old_value, const Variant &new_value);
+    void _remove_relationships_to(Entity *entity);
+    void _on_entity_relationship_added(Object *entity, Object *relationship);
+    void _on_entity_relationship_removed(Object *entity, Object *relationship);
     
     void _process_observer_queue();
+    bool _is_type_observed(int type_id) const;
     void _handle_observer_component_added(Entity *entity, Component *component);
     void _handle_observer_component_removed(Entity *entity, Component *component);
     void _handle_observer_component_changed(Entity *entity, Component *component, const StringName &property, const Variant &new_value, const Variant &old_value);
@@ -0,0 +1,62 @@
+#include "archetype.h"
+#include "entity.h"
+#include "component.h"
+
+using namespace godot;
+
+Archetype::Archetype(const LocalVector<int> &p_sorted_types) {
+    types = p_sorted_types;
+    columns.resize(types.size());
+    int max_type = types.is_empty() ? -1 : types[types.size() - 1];
+    column_index.resize(max_type + 1);
+    for (int i = 0; i <= max_type; i++) {
+        column_index[i] = -1;
+    }
+    for (uint32_t i = 0; i < types.size(); i++) {
+        mask.set(types[i]);
+        column_index[types[i]] = i;
+    }
+}
+
+uint32_t Archetype::size() const {
+    return entities.size();
+}
+
+uint32_t Archetype::add_row(Entity *p_entity) {
+    uint32_t row = entities.size();
+    entities.push_back(p_entity);
+    for (uint32_t c = 0; c < columns.size(); c++) {
+        columns[c].push_back(Ref<Component>());
+    }
+    return row;
+}
+
+void Archetype::reserve(uint32_t p_additional) {
+    uint32_t total = entities.size() + p_additional;
+    entities.reserve(total);
+    for (uint32_t c = 0; c < columns.size(); c++) {
+        columns[c].reserve(total);
+    }
+}
+
+Entity *Archetype::remove_row(uint32_t p_row) {
+    uint32_t last = entities.size() - 1;
+    entities.remove_at_unordered(p_row);
+    for (uint32_t c = 0; c < columns.size(); c++) {
+        columns[c].remove_at_unordered(p_row);
+    }
+    // The last row was swapped into p_row; its owner needs to learn the new row.
+    return p_row != last ? entities[p_row] : nullptr;
+}
+
+Ref<Component> Archetype::get_component(uint32_t p_row, int p_type) const {
+    int col = get_column(p_type);
+    if (col < 0) {
+        return Ref<Component>();
+    }
+    return columns[col][p_row];
+}
+
+void Archetype::set_component(uint32_t p_row, int p_column, const Ref<Component> &p_component) {
+    columns[p_column][p_row] = p_component;
+}
@@ -0,0 +1,267 @@
+#include "command_buffer.h"
+#include "component.h"
+#include "entity.h"
+#include "gecs.h"
+#include "relationship.h"
+#include "system_scheduler.h"
+#include "world.h"
+
+#include <godot_cpp/core/class_db.hpp>
+#include <godot_cpp/templates/hash_map.hpp>
+#include <godot_cpp/templates/hash_set.hpp>
+#include <godot_cpp/variant/utility_functions.hpp>
+
+using namespace godot;
+
+thread_local CommandBuffer *CommandBuffer::lane_buffer = nullptr;
+thread_local uint32_t CommandBuffer::lane_index = 0;
+
+void CommandBuffer::_bind_methods() {
+    ClassDB::bind_method(D_METHOD("add_entity", "entity"), &CommandBuffer::add_entity);
+    ClassDB::bind_method(D_METHOD("remove_entity", "entity"), &CommandBuffer::remove_entity);
+    ClassDB::bind_method(D_METHOD("add_component", "entity", "component"), &CommandBuffer::add_component);
+    ClassDB::bind_method(D_METHOD("remove_component", "entity", "component"), &CommandBuffer::remove_component);
+    ClassDB::bind_method(D_METHOD("add_relationship", "entity", "relationship"), &CommandBuffer::add_relationship);
+    ClassDB::bind_method(D_METHOD("remove_relationship", "entity", "relationship"), &CommandBuffer::remove_relationship);
+
+    ClassDB::bind_method(D_METHOD("flush"), &CommandBuffer::flush);
+    ClassDB::bind_method(D_METHOD("clear"), &CommandBuffer::clear);
+    ClassDB::bind_method(D_METHOD("is_empty"), &CommandBuffer::is_empty);
+    ClassDB::bind_method(D_METHOD("size"), &CommandBuffer::size);
+}
+
+void CommandBuffer::_record(CommandType p_type, Entity *p_entity, const Ref<Resource> &p_resource) {
+    if (!p_entity) return;
+    Command command;
+    command.type = p_type;
+    command.entity = p_entity->get_instance_id();
+    command.resource = p_resource;
+    if (lane_buffer == this) {
+        lanes[lane_index].push_back(command);
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    commands.push_back(command);
+}
+
+void CommandBuffer::_begin_lanes(uint32_t p_count) {
+    lanes.resize(p_count);
+}
+
+void CommandBuffer::_merge_lane(uint32_t p_lane) {
+    std::lock_guard<std::mutex> lock(mutex);
+    commands.append_array(lanes[p_lane]);
+    lanes[p_lane].clear();
+}
+
+void CommandBuffer::_merge_lanes() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (uint32_t i = 0; i < lanes.size(); i++) {
+        commands.append_array(lanes[i]);
+    }
+    lanes.clear();
+}
+
+void CommandBuffer::_set_world(World *p_world) {
+    world_id = p_world ? p_world->get_instance_id() : 0;
+}
+
+World *CommandBuffer::_get_world() const {
+    World *world = world_id ? Object::cast_to<World>(ObjectDB::get_instance(world_id)) : nullptr;
+    if (!world && GECS::get_singleton()) {
+        world = GECS::get_singleton()->get_world();
+    }
+    return world;
+}
+
+void CommandBuffer::add_entity(Entity *p_entity) {
+    _record(ADD_ENTITY, p_entity);
+}
+
+void CommandBuffer::remove_entity(Entity *p_entity) {
+    _record(REMOVE_ENTITY, p_entity);
+}
+
+void CommandBuffer::add_component(Entity *p_entity, const Ref<Component> &p_component) {
+    if (p_component.is_null()) return;
+    _record(ADD_COMPONENT, p_entity, p_component);
+}
+
+void CommandBuffer::remove_component(Entity *p_entity, const Ref<Resource> &p_component) {
+    if (p_component.is_null()) return;
+    _record(REMOVE_COMPONENT, p_entity, p_component);
+}
+
+void CommandBuffer::add_relationship(Entity *p_entity, const Ref<Relationship> &p_relationship) {
+    if (p_relationship.is_null()) return;
+    _record(ADD_RELATIONSHIP, p_entity, p_relationship);
+}
+
+void CommandBuffer::remove_relationship(Entity *p_entity, const Ref<Relationship> &p_relationship) {
+    if (p_relationship.is_null()) return;
+    _record(REMOVE_RELATIONSHIP, p_entity, p_relationship);
+}
+
+void CommandBuffer::flush() {
+    if (SystemScheduler::is_worker_thread()) {
+        SystemScheduler::defer_call(Callable(this, "flush"));
+        return;
+    }
+
+    LocalVector<Command> pending;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending = commands;
+        commands.clear();
+    }
+    if (pending.is_empty()) return;
+
+    // Net component state per touched entity; a null component means "removed".
+    struct EntityChanges {
+        uint64_t id = 0;
+        bool removed = false;
+        LocalVector<int> types;
+        LocalVector<Ref<Component>> components;
+    };
+    LocalVector<EntityChanges> changes;
+    HashMap<uint64_t, uint32_t> change_index;
+    Array added;
+    HashSet<uint64_t> added_ids;
+
+    for (uint32_t i = 0; i < pending.size(); i++) {
+        const Command &command = pending[i];
+        Entity *entity = Object::cast_to<Entity>(ObjectDB::get_instance(command.entity));
+        if (!entity) continue;
+
+        if (command.type == ADD_ENTITY) {
+            if (!added_ids.has(command.entity)) {
+                added_ids.insert(command.entity);
+                added.push_back(entity);
+            }
+            continue;
+        }
+        if (command.type == ADD_RELATIONSHIP || command.type == REMOVE_RELATIONSHIP) {
+            continue;
+        }
+
+        const uint32_t *slot = change_index.getptr(command.entity);
+        if (!slot) {
+            EntityChanges entry;
+            entry.id = command.entity;
+            changes.push_back(entry);
+            change_index.insert(command.entity, changes.size() - 1);
+            slot = change_index.getptr(command.entity);
+        }
+        EntityChanges &entry = changes[*slot];
+        if (command.type == REMOVE_ENTITY) {
+            entry.removed = true;
+            continue;
+        }
+
+        Ref<Component> component;
+        int type_id;
+        if (command.type == ADD_COMPONENT) {
+            component = command.resource;
+            type_id = component->get_type_id();
+        } else {
+            type_id = GECS::get_component_type_id(command.resource);
+        }
+        if (type_id < 0) continue;
+        int64_t existing = entry.types.find(type_id);
+        if (existing >= 0) {
+            entry.components[existing] = component;
+        } else {
+            entry.types.push_back(type_id);
+            entry.components.push_back(component);
+        }
+    }
+
+    if (!added.is_empty()) {
+        World *world = _get_world();
+        if (world) {
+            world->add_entities(added);
+        } else {
+            UtilityFunctions::push_error("CommandBuffer has no world to add " + String::num_int64(added.size()) + " entities to.");
+        }
+    }
+
+    // Every entity moves first, with one query cache pass per world; the signals
+    // go out afterwards, so their handlers already see the new archetypes.
+    LocalVector<World *> batch_worlds;
+    LocalVector<uint64_t> moved;
+    LocalVector<LocalVector<Ref<Component>>> removed_components;
+    LocalVector<LocalVector<Ref<Component>>> added_components;
+    for (uint32_t i = 0; i < changes.size(); i++) {
+        if (changes[i].removed || changes[i].types.is_empty()) continue;
+        Entity *entity = Object::cast_to<Entity>(ObjectDB::get_instance(changes[i].id));
+        if (!entity) continue;
+        World *world = entity->get_world();
+        if (!world) {
+            entity->_apply_component_changes(changes[i].types, changes[i].components);
+            continue;
+        }
+        if (batch_worlds.find(world) < 0) {
+            batch_worlds.push_back(world);
+            world->_begin_move_batch();
+        }
+        moved.push_back(changes[i].id);
+        removed_components.resize(moved.size());
+        added_components.resize(moved.size());
+        entity->_move_for_component_changes(changes[i].types, changes[i].components, removed_components[moved.size() - 1], added_components[moved.size() - 1]);
+    }
+    for (uint32_t i = 0; i < batch_worlds.size(); i++) {
+        batch_worlds[i]->_end_move_batch();
+    }
+    // Signal handlers may free entities, so each pass looks them up again.
+    for (uint32_t i = 0; i < moved.size(); i++) {
+        Entity *entity = Object::cast_to<Entity>(ObjectDB::get_instance(moved[i]));
+        if (entity) {
+            entity->_announce_component_changes(removed_components[i], added_components[i]);
+        }
+    }
+
+    for (uint32_t i = 0; i < pending.size(); i++) {
+        const Command &command = pending[i];
+        if (command.type != ADD_RELATIONSHIP && command.type != REMOVE_RELATIONSHIP) continue;
+        Entity *entity = Object::cast_to<Entity>(ObjectDB::get_instance(command.entity));
+        if (!entity) continue;
+        if (command.type == ADD_RELATIONSHIP) {
+            entity->add_relationship(command.resource);
+        } else {
+            entity->remove_relationship(command.resource);
+        }
+    }
+
+    LocalVector<World *> removal_worlds;
+    LocalVector<Array> removals;
+    for (uint32_t i = 0; i < changes.size(); i++) {
+        if (!changes[i].removed) continue;
+        Entity *entity = Object::cast_to<Entity>(ObjectDB::get_instance(changes[i].id));
+        if (!entity || !entity->get_world()) continue;
+        int64_t index = removal_worlds.find(entity->get_world());
+        if (index < 0) {
+            index = removal_worlds.size();
+            removal_worlds.push_back(entity->get_world());
+            removals.push_back(Array());
+        }
+        removals[index].push_back(entity);
+    }
+    for (uint32_t i = 0; i < removal_worlds.size(); i++) {
+        removal_worlds[i]->remove_entities(removals[i]);
+    }
+}
+
+void CommandBuffer::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    commands.clear();
+}
+
+bool CommandBuffer::is_empty() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return commands.is_empty();
+}
+
+int CommandBuffer::size() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return commands.size();
+}
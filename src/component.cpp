@@ -1,4 +1,5 @@
 #include "component.h"
+#include "gecs.h"
 #include <godot_cpp/core/class_db.hpp>
 #include <godot_cpp/classes/script.hpp>
 #include <godot_cpp/variant/utility_functions.hpp>
@@ -13,6 +14,7 @@ void Component::_bind_methods() {
     ClassDB::bind_method(D_METHOD("emit_property_changed", "property_name", "old_value", "new_value"), &Component::emit_property_changed);
     ClassDB::bind_method(D_METHOD("serialize"), &Component::serialize);
     ClassDB::bind_method(D_METHOD("equals", "other"), &Component::equals);
+    ClassDB::bind_method(D_METHOD("is_shared"), &Component::is_shared);
 
     ADD_SIGNAL(MethodInfo("property_changed", 
         PropertyInfo(Variant::OBJECT, "component"),
@@ -68,6 +70,35 @@ bool Component::equals(const Ref<Component> &other) {
     return true;
 }
 
+int Component::get_type_id() const {
+    int id = type_id.load(std::memory_order_relaxed);
+    if (id < 0) {
+        Ref<Script> scr = get_script();
+        if (scr.is_valid()) {
+            id = GECS::get_component_type_id_for_object(scr.ptr());
+            type_id.store(id, std::memory_order_relaxed);
+        }
+    }
+    return id;
+}
+
+void Component::_set_shared(bool p_shared) {
+    shared = p_shared;
+}
+
+bool Component::is_shared() const {
+    return shared;
+}
+
+void Component::_mark_added(uint64_t p_tick) {
+    added_tick = p_tick;
+    changed_tick = p_tick;
+}
+
+void Component::_mark_changed(uint64_t p_tick) {
+    changed_tick = p_tick;
+}
+
 void Component::emit_property_changed(const String &property_name, const Variant &old_value, const Variant &new_value) {
     emit_signal("property_changed", this, property_name, old_value, new_value);
 }
\ No newline at end of file
@@ -0,0 +1,152 @@
+#include "component_predicate.h"
+
+#include <godot_cpp/classes/object.hpp>
+#include <godot_cpp/variant/utility_functions.hpp>
+
+using namespace godot;
+
+bool ComponentPredicate::parse_operator(const String &p_name, Operator &r_op) {
+    if (p_name == "_eq") {
+        r_op = OP_EQ;
+    } else if (p_name == "_ne") {
+        r_op = OP_NE;
+    } else if (p_name == "_gt") {
+        r_op = OP_GT;
+    } else if (p_name == "_lt") {
+        r_op = OP_LT;
+    } else if (p_name == "_gte") {
+        r_op = OP_GTE;
+    } else if (p_name == "_lte") {
+        r_op = OP_LTE;
+    } else if (p_name == "_in") {
+        r_op = OP_IN;
+    } else if (p_name == "_nin") {
+        r_op = OP_NIN;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void ComponentPredicate::compile(int p_type_id, const Dictionary &p_query) {
+    type_id = p_type_id;
+    properties.clear();
+
+    Array property_names = p_query.keys();
+    for (int i = 0; i < property_names.size(); i++) {
+        Variant tests_var = p_query[property_names[i]];
+        if (tests_var.get_type() != Variant::DICTIONARY) {
+            UtilityFunctions::push_error("Component query for property '" + String(property_names[i]) + "' must be a Dictionary of operators");
+            continue;
+        }
+        Dictionary tests = tests_var;
+
+        PropertyTests property_tests;
+        property_tests.property = property_names[i];
+        Array op_names = tests.keys();
+        for (int j = 0; j < op_names.size(); j++) {
+            Test test;
+            if (!parse_operator(op_names[j], test.op)) {
+                UtilityFunctions::push_error("Unknown component query operator: " + String(op_names[j]));
+                continue;
+            }
+            test.operand = tests[op_names[j]];
+            if (test.op == OP_IN || test.op == OP_NIN) {
+                if (test.operand.get_type() < Variant::ARRAY) {
+                    UtilityFunctions::push_error("Component query operator " + String(op_names[j]) + " expects an Array");
+                    continue;
+                }
+                Array values = test.operand;
+                for (int k = 0; k < values.size(); k++) {
+                    test.operands.push_back(values[k]);
+                }
+            }
+            property_tests.tests.push_back(test);
+        }
+        // A property with no usable tests still has to exist on the component.
+        properties.push_back(property_tests);
+    }
+}
+
+bool ComponentPredicate::evaluate(const Object *p_component) const {
+    if (!p_component) {
+        return false;
+    }
+    Variant component = p_component;
+    for (uint32_t i = 0; i < properties.size(); i++) {
+        const PropertyTests &property_tests = properties[i];
+        bool valid = false;
+        Variant value = component.get_named(property_tests.property, valid);
+        if (!valid) {
+            return false;
+        }
+        for (uint32_t j = 0; j < property_tests.tests.size(); j++) {
+            if (!_test(property_tests.tests[j], value)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool ComponentPredicate::_equals(const Variant &p_a, const Variant &p_b) {
+    return _compare(Variant::OP_EQUAL, p_a, p_b);
+}
+
+bool ComponentPredicate::_compare(Variant::Operator p_op, const Variant &p_a, const Variant &p_b) {
+    Variant::Type a_type = p_a.get_type();
+    Variant::Type b_type = p_b.get_type();
+    if (a_type == Variant::INT && b_type == Variant::INT) {
+        int64_t a = p_a;
+        int64_t b = p_b;
+        switch (p_op) {
+            case Variant::OP_EQUAL: return a == b;
+            case Variant::OP_NOT_EQUAL: return a != b;
+            case Variant::OP_GREATER: return a > b;
+            case Variant::OP_LESS: return a < b;
+            case Variant::OP_GREATER_EQUAL: return a >= b;
+            case Variant::OP_LESS_EQUAL: return a <= b;
+            default: break;
+        }
+    } else if ((a_type == Variant::INT || a_type == Variant::FLOAT) && (b_type == Variant::INT || b_type == Variant::FLOAT)) {
+        double a = p_a;
+        double b = p_b;
+        switch (p_op) {
+            case Variant::OP_EQUAL: return a == b;
+            case Variant::OP_NOT_EQUAL: return a != b;
+            case Variant::OP_GREATER: return a > b;
+            case Variant::OP_LESS: return a < b;
+            case Variant::OP_GREATER_EQUAL: return a >= b;
+            case Variant::OP_LESS_EQUAL: return a <= b;
+            default: break;
+        }
+    }
+
+    Variant result;
+    bool valid = false;
+    Variant::evaluate(p_op, p_a, p_b, result, valid);
+    return valid && result.booleanize();
+}
+
+bool ComponentPredicate::_test(const Test &p_test, const Variant &p_value) {
+    switch (p_test.op) {
+        case OP_EQ: return _compare(Variant::OP_EQUAL, p_value, p_test.operand);
+        case OP_NE: return _compare(Variant::OP_NOT_EQUAL, p_value, p_test.operand);
+        case OP_GT: return _compare(Variant::OP_GREATER, p_value, p_test.operand);
+        case OP_LT: return _compare(Variant::OP_LESS, p_value, p_test.operand);
+        case OP_GTE: return _compare(Variant::OP_GREATER_EQUAL, p_value, p_test.operand);
+        case OP_LTE: return _compare(Variant::OP_LESS_EQUAL, p_value, p_test.operand);
+        case OP_IN:
+        case OP_NIN: {
+            bool found = false;
+            for (uint32_t i = 0; i < p_test.operands.size(); i++) {
+                if (_equals(p_value, p_test.operands[i])) {
+                    found = true;
+                    break;
+                }
+            }
+            return p_test.op == OP_IN ? found : !found;
+        }
+    }
+    return false;
+}
@@ -1,6 +1,11 @@
 #include "entity.h"
 #include "component.h"
 #include "relationship.h"
+#include "world.h"
+#include "archetype.h"
+#include "gecs.h"
+#include "system_scheduler.h"
+#include "prefab.h"
 
 #include <godot_cpp/core/class_db.hpp>
 #include <godot_cpp/variant/utility_functions.hpp>
@@ -20,7 +25,10 @@ void Entity::_bind_methods() {
     ClassDB::bind_method(D_METHOD("remove_all_components"), &Entity::remove_all_components);
     ClassDB::bind_method(D_METHOD("deferred_remove_component", "component"), &Entity::deferred_remove_component);
     ClassDB::bind_method(D_METHOD("get_component", "component_script"), &Entity::get_component);
+    ClassDB::bind_method(D_METHOD("get_component_mut", "component_script"), &Entity::get_component_mut);
     ClassDB::bind_method(D_METHOD("has_component", "component_script"), &Entity::has_component);
+    ClassDB::bind_method(D_METHOD("get_components"), &Entity::get_components);
+    ClassDB::bind_method(D_METHOD("get_handle"), &Entity::get_handle);
     
     ClassDB::bind_method(D_METHOD("add_relationship", "relationship"), &Entity::add_relationship);
     ClassDB::bind_method(D_METHOD("add_relationships", "relationships"), &Entity::add_relationships);
@@ -38,6 +46,13 @@ void Entity::_bind_methods() {
     ClassDB::bind_method(D_METHOD("set_enabled", "p_value"), &Entity::set_enabled);
     ADD_PROPERTY(PropertyInfo(Variant::BOOL, "enabled"), "set_enabled", "is_enabled");
 
+    GDVIRTUAL_BIND(on_ready);
+    GDVIRTUAL_BIND(on_update, "delta");
+    GDVIRTUAL_BIND(on_destroy);
+    GDVIRTUAL_BIND(on_disable);
+    GDVIRTUAL_BIND(on_enable);
+    GDVIRTUAL_BIND(define_components);
+
     ADD_SIGNAL(MethodInfo("component_added", PropertyInfo(Variant::OBJECT, "entity"), PropertyInfo(Variant::OBJECT, "component")));
     ADD_SIGNAL(MethodInfo("component_removed", PropertyInfo(Variant::OBJECT, "entity"), PropertyInfo(Variant::OBJECT, "component")));
     ADD_SIGNAL(MethodInfo("component_property_changed",
@@ -53,76 +68,114 @@ void Entity::_bind_methods() {
 void Entity::_notification(int p_what) {
     if (p_what == NOTIFICATION_READY && !Engine::get_singleton()->is_editor_hint()) {
         _initialize();
+    } else if (p_what == NOTIFICATION_PREDELETE && world) {
+        world->_detach_entity(this);
     }
 }
 
 void Entity::_initialize() {
-    Array defined_components = define_components();
-    for (int i = 0; i < defined_components.size(); i++) {
-        Ref<Resource> res = defined_components[i];
-        if (res.is_valid()) {
-            component_resources.push_back(res);
+    if (initialized) return;
+    initialized = true;
+    _resolve_script_overrides();
+    if (!components_defined) {
+        components_defined = true;
+        Array defined_components = define_components();
+        for (int i = 0; i < defined_components.size(); i++) {
+            Ref<Resource> res = defined_components[i];
+            if (res.is_valid()) {
+                component_resources.push_back(res);
+            }
         }
-    }
-    
-    for (int i = 0; i < component_resources.size(); i++) {
-        Ref<Resource> res = component_resources[i];
-        if (res.is_valid()) {
-            add_component(res->duplicate());
+
+        for (int i = 0; i < component_resources.size(); i++) {
+            Ref<Component> res = component_resources[i];
+            if (res.is_null()) continue;
+            const ComponentTemplate *component_template = GECS::get_component_template(res);
+            add_component(component_template ? component_template->instantiate() : Ref<Component>(res->duplicate()));
         }
     }
     
     on_ready();
 }
 
+void Entity::_resolve_script_overrides() {
+    script_overrides = OVERRIDES_RESOLVED;
+    if (GDVIRTUAL_IS_OVERRIDDEN(on_ready)) script_overrides |= OVERRIDE_ON_READY;
+    if (GDVIRTUAL_IS_OVERRIDDEN(on_update)) script_overrides |= OVERRIDE_ON_UPDATE;
+    if (GDVIRTUAL_IS_OVERRIDDEN(on_destroy)) script_overrides |= OVERRIDE_ON_DESTROY;
+    if (GDVIRTUAL_IS_OVERRIDDEN(on_disable)) script_overrides |= OVERRIDE_ON_DISABLE;
+    if (GDVIRTUAL_IS_OVERRIDDEN(on_enable)) script_overrides |= OVERRIDE_ON_ENABLE;
+    if (GDVIRTUAL_IS_OVERRIDDEN(define_components)) script_overrides |= OVERRIDE_DEFINE_COMPONENTS;
+}
+
 void Entity::on_ready() {
-    if (has_method("on_ready")) {
-        call("on_ready");
+    if (_is_overridden(OVERRIDE_ON_READY)) {
+        GDVIRTUAL_CALL(on_ready);
     }
 }
 
 void Entity::on_update(double delta) {
-    if (has_method("on_update")) {
-        call("on_update", delta);
+    if (_is_overridden(OVERRIDE_ON_UPDATE)) {
+        GDVIRTUAL_CALL(on_update, delta);
     }
 }
 
 void Entity::on_destroy() {
-    if (has_method("on_destroy")) {
-        call("on_destroy");
+    if (_is_overridden(OVERRIDE_ON_DESTROY)) {
+        GDVIRTUAL_CALL(on_destroy);
     }
 }
 
 void Entity::on_disable() {
-    if (has_method("on_disable")) {
-        call("on_disable");
+    if (_is_overridden(OVERRIDE_ON_DISABLE)) {
+        GDVIRTUAL_CALL(on_disable);
     }
 }
 
 void Entity::on_enable() {
-    if (has_method("on_enable")) {
-        call("on_enable");
+    if (_is_overridden(OVERRIDE_ON_ENABLE)) {
+        GDVIRTUAL_CALL(on_enable);
     }
 }
 
 Array Entity::define_components() {
-    if (has_method("define_components")) {
-        return call("define_components");
+    Array ret;
+    if (_is_overridden(OVERRIDE_DEFINE_COMPONENTS) && GDVIRTUAL_CALL(define_components, ret)) {
+        return ret;
     }
     return Array();
 }
 
 void Entity::add_component(const Ref<Component> &p_component) {
     if (p_component.is_null()) return;
-    Ref<Script> scr = p_component->get_script();
-    if (scr.is_null()) return;
+    if (world && SystemScheduler::is_worker_thread()) {
+        SystemScheduler::defer_call(Callable(this, "add_component").bind(p_component));
+        return;
+    }
+    int type_id = p_component->get_type_id();
+    if (type_id < 0) {
+        if (!GECS::get_singleton()) {
+            UtilityFunctions::push_error("Cannot add a component before the GECS singleton exists to assign its type ID.");
+        } else {
+            UtilityFunctions::push_error("Cannot add a component without a script.");
+        }
+        return;
+    }
 
-    String path = scr->get_path();
-    if (components.has(path)) {
-        remove_component(Ref<Component>(components[path]));
+    Ref<Component> existing = get_component_by_type_id(type_id);
+    if (existing.is_valid()) {
+        remove_component(existing);
+    }
+    if (world) {
+        world->_set_entity_component(this, type_id, p_component);
+    } else {
+        components[type_id] = p_component;
+        signature.set(type_id);
+    }
+    // Shared components are never written in place, see get_component_mut().
+    if (!p_component->is_shared()) {
+        p_component->connect("property_changed", callable_mp(this, &Entity::_on_component_property_changed));
     }
-    components[path] = p_component;
-    p_component->connect("property_changed", callable_mp(this, &Entity::_on_component_property_changed));
     emit_signal("component_added", this, p_component);
 }
 
@@ -132,35 +185,33 @@ void Entity::add_components(const Array &p_components) {
     }
 }
 
+Ref<Component> Entity::get_component_by_type_id(int p_type_id) const {
+    if (archetype) {
+        return archetype->get_component(archetype_row, p_type_id);
+    }
+    const Ref<Component> *comp = components.getptr(p_type_id);
+    return comp ? *comp : Ref<Component>();
+}
+
 void Entity::remove_component(const Ref<Resource> &p_component) {
-    if (p_component.is_null()) return;
-    
-    String resource_path;
-    
-    Ref<Component> comp_instance = Object::cast_to<Component>(p_component.ptr());
-    if (comp_instance.is_valid()) {
-        Ref<Script> scr = comp_instance->get_script();
-        if (scr.is_null()) return;
-        resource_path = scr->get_path();
-    } else {
-        Ref<Script> scr = Object::cast_to<Script>(p_component.ptr());
-        if (scr.is_valid()) {
-            resource_path = scr->get_path();
-        } else {
-            resource_path = p_component->get_path();
-        }
+    if (world && SystemScheduler::is_worker_thread()) {
+        SystemScheduler::defer_call(Callable(this, "remove_component").bind(p_component));
+        return;
     }
-    
-    if (resource_path.is_empty()) return;
+    int type_id = GECS::get_component_type_id(p_component);
+    if (!get_signature().has(type_id)) return;
 
-    if (components.has(resource_path)) {
-        Ref<Component> removed_comp = components[resource_path];
-        if (removed_comp.is_valid() && removed_comp->is_connected("property_changed", callable_mp(this, &Entity::_on_component_property_changed))) {
-            removed_comp->disconnect("property_changed", callable_mp(this, &Entity::_on_component_property_changed));
-        }
-        components.erase(resource_path);
-        emit_signal("component_removed", this, removed_comp);
+    Ref<Component> removed_comp = get_component_by_type_id(type_id);
+    if (removed_comp.is_valid() && removed_comp->is_connected("property_changed", callable_mp(this, &Entity::_on_component_property_changed))) {
+        removed_comp->disconnect("property_changed", callable_mp(this, &Entity::_on_component_property_changed));
+    }
+    if (world) {
+        world->_erase_entity_component(this, type_id);
+    } else {
+        components.erase(type_id);
+        signature.unset(type_id);
     }
+    emit_signal("component_removed", this, removed_comp);
 }
 
 void Entity::remove_components(const Array &p_components) {
@@ -170,53 +221,135 @@ void Entity::remove_components(const Array &p_components) {
 }
 
 void Entity::remove_all_components() {
-    Array comps = components.values();
+    Array comps = get_components();
     for (int i = 0; i < comps.size(); i++) {
         remove_component(comps[i]);
     }
 }
 
+void Entity::_apply_component_changes(const LocalVector<int> &p_types, const LocalVector<Ref<Component>> &p_components) {
+    if (!world) {
+        for (uint32_t i = 0; i < p_types.size(); i++) {
+            if (p_components[i].is_valid()) {
+                add_component(p_components[i]);
+            } else if (get_signature().has(p_types[i])) {
+                remove_component(get_component_by_type_id(p_types[i]));
+            }
+        }
+        return;
+    }
+
+    LocalVector<Ref<Component>> removed;
+    LocalVector<Ref<Component>> added;
+    _move_for_component_changes(p_types, p_components, removed, added);
+    _announce_component_changes(removed, added);
+}
+
+void Entity::_move_for_component_changes(const LocalVector<int> &p_types, const LocalVector<Ref<Component>> &p_components, LocalVector<Ref<Component>> &r_removed, LocalVector<Ref<Component>> &r_added) {
+    LocalVector<int> removed_types;
+    LocalVector<int> added_types;
+    for (uint32_t i = 0; i < p_types.size(); i++) {
+        Ref<Component> existing = get_component_by_type_id(p_types[i]);
+        if (p_components[i].is_null()) {
+            if (existing.is_valid()) {
+                r_removed.push_back(existing);
+                removed_types.push_back(p_types[i]);
+            }
+        } else if (existing != p_components[i]) {
+            // A replaced component keeps its type, so it never leaves the archetype.
+            if (existing.is_valid()) {
+                r_removed.push_back(existing);
+            }
+            r_added.push_back(p_components[i]);
+            added_types.push_back(p_types[i]);
+        }
+    }
+
+    for (uint32_t i = 0; i < r_removed.size(); i++) {
+        if (r_removed[i]->is_connected("property_changed", callable_mp(this, &Entity::_on_component_property_changed))) {
+            r_removed[i]->disconnect("property_changed", callable_mp(this, &Entity::_on_component_property_changed));
+        }
+    }
+    world->_apply_component_changes(this, added_types, r_added, removed_types);
+}
+
+void Entity::_announce_component_changes(const LocalVector<Ref<Component>> &p_removed, const LocalVector<Ref<Component>> &p_added) {
+    for (uint32_t i = 0; i < p_removed.size(); i++) {
+        emit_signal("component_removed", this, p_removed[i]);
+    }
+    for (uint32_t i = 0; i < p_added.size(); i++) {
+        p_added[i]->connect("property_changed", callable_mp(this, &Entity::_on_component_property_changed));
+        emit_signal("component_added", this, p_added[i]);
+    }
+}
+
 void Entity::deferred_remove_component(const Ref<Component> &p_component) {
     call_deferred("remove_component", p_component);
 }
 
 void Entity::_on_component_property_changed(Object *component, const StringName &property, const Variant &old_value, const Variant &new_value) {
+    // Indexes and value-query versions must follow disabled entities too, whose world signals are disconnected.
+    if (world) {
+        Component *changed = Object::cast_to<Component>(component);
+        if (changed) {
+            // Stamped from the entity's own world, which need not be the GECS one.
+            changed->_mark_changed(world->_get_change_tick());
+        }
+        world->_on_component_value_changed(this, changed, property, new_value);
+    }
     emit_signal("component_property_changed", this, component, property, old_value, new_value);
 }
 
 Ref<Component> Entity::get_component(const Ref<Resource> &p_component_script) const {
-    if (p_component_script.is_null()) {
-        return Ref<Component>();
+    return get_component_by_type_id(GECS::get_component_type_id(p_component_script));
+}
+
+Ref<Component> Entity::get_component_mut(const Ref<Resource> &p_component_script) {
+    int type_id = GECS::get_component_type_id(p_component_script);
+    Ref<Component> component = get_component_by_type_id(type_id);
+    if (component.is_null() || !component->is_shared()) {
+        return component;
     }
-    
-    String path;
-    Ref<Script> scr = Object::cast_to<Script>(p_component_script.ptr());
-    if (scr.is_valid()) {
-        path = scr->get_path();
+
+    // Copy on first write. The type doesn't change, so the entity keeps its archetype row.
+    Ref<Component> copy = component->duplicate();
+    if (archetype) {
+        archetype->set_component(archetype_row, archetype->get_column(type_id), copy);
     } else {
-        path = p_component_script->get_path();
+        components[type_id] = copy;
     }
-    
-    if (components.has(path)) {
-        return components[path];
-    }
-    return Ref<Component>();
+    copy->connect("property_changed", callable_mp(this, &Entity::_on_component_property_changed));
+    return copy;
 }
 
 bool Entity::has_component(const Ref<Resource> &p_component_script) const {
-    if (p_component_script.is_null()) {
-        return false;
-    }
-    
-    String path;
-    Ref<Script> scr = Object::cast_to<Script>(p_component_script.ptr());
-    if (scr.is_valid()) {
-        path = scr->get_path();
+    return get_signature().has(GECS::get_component_type_id(p_component_script));
+}
+
+const ComponentMask &Entity::get_signature() const {
+    return archetype ? archetype->mask : signature;
+}
+
+World *Entity::get_world() const {
+    return world;
+}
+
+int64_t Entity::get_handle() const {
+    return int64_t(handle);
+}
+
+Array Entity::get_components() const {
+    Array result;
+    if (archetype) {
+        for (uint32_t c = 0; c < archetype->columns.size(); c++) {
+            result.push_back(archetype->columns[c][archetype_row]);
+        }
     } else {
-        path = p_component_script->get_path();
+        for (const KeyValue<int, Ref<Component>> &E : components) {
+            result.push_back(E.value);
+        }
     }
-    
-    return components.has(path);
+    return result;
 }
 
 void Entity::add_relationship(const Ref<Relationship> &p_relationship) {
@@ -243,6 +376,14 @@ void Entity::remove_relationship(const Ref<Relationship> &p_relationship) {
     }
 }
 
+// Removes this exact relationship object, not everything that matches it.
+void Entity::_remove_relationship_instance(const Ref<Relationship> &p_relationship) {
+    int64_t index = relationships.find(p_relationship);
+    if (index < 0) return;
+    relationships.remove_at(index);
+    emit_signal("relationship_removed", this, p_relationship);
+}
+
 void Entity::remove_relationships(const Array &p_relationships) {
     for (int i = 0; i < p_relationships.size(); ++i) {
         remove_relationship(p_relationships[i]);
@@ -0,0 +1,66 @@
+#include "entity_table.h"
+
+using namespace godot;
+
+uint64_t EntityTable::add(Entity *p_entity) {
+    uint32_t index;
+    if (!free_slots.is_empty()) {
+        index = free_slots[free_slots.size() - 1];
+        free_slots.resize(free_slots.size() - 1);
+    } else {
+        index = slots.size();
+        slots.push_back(Slot());
+    }
+
+    Slot &slot = slots[index];
+    slot.entity = p_entity;
+    slot.dense_index = dense.size();
+    dense.push_back(p_entity);
+    dense_slots.push_back(index);
+    return (uint64_t(slot.generation) << 32) | index;
+}
+
+void EntityTable::reserve(uint32_t p_additional) {
+    // Freed slots are reused first; only the remainder needs new ones.
+    if (p_additional > free_slots.size()) {
+        slots.reserve(slots.size() + p_additional - free_slots.size());
+    }
+    dense.reserve(dense.size() + p_additional);
+    dense_slots.reserve(dense_slots.size() + p_additional);
+}
+
+bool EntityTable::remove(uint64_t p_handle) {
+    if (!is_valid(p_handle)) {
+        return false;
+    }
+    uint32_t index = handle_index(p_handle);
+    uint32_t position = slots[index].dense_index;
+    uint32_t last = dense.size() - 1;
+    if (position != last) {
+        dense[position] = dense[last];
+        dense_slots[position] = dense_slots[last];
+        slots[dense_slots[position]].dense_index = position;
+    }
+    dense.resize(last);
+    dense_slots.resize(last);
+    _release(index);
+    return true;
+}
+
+void EntityTable::clear() {
+    for (uint32_t i = 0; i < dense_slots.size(); i++) {
+        _release(dense_slots[i]);
+    }
+    dense.clear();
+    dense_slots.clear();
+}
+
+void EntityTable::_release(uint32_t p_index) {
+    Slot &slot = slots[p_index];
+    slot.entity = nullptr;
+    slot.generation++;
+    if (slot.generation == 0) {
+        slot.generation = 1;
+    }
+    free_slots.push_back(p_index);
+}
@@ -3,11 +3,16 @@
 #include "system.h"
 #include "entity.h"
 #include "component.h"
+#include "query_plan.h"
+#include "prefab.h"
+#include "dense_bitset.h"
 
 #include <godot_cpp/core/class_db.hpp>
 #include <godot_cpp/variant/utility_functions.hpp>
+#include <godot_cpp/classes/class_db_singleton.hpp>
 #include <godot_cpp/classes/scene_tree.hpp>
 #include <godot_cpp/classes/window.hpp>
+#include <godot_cpp/templates/hash_set.hpp>
 
 using namespace godot;
 
@@ -24,6 +29,14 @@ GECS::~GECS() {
     if (singleton == this) {
         singleton = nullptr;
     }
+    for (const KeyValue<String, QueryPlan *> &E : query_plans) {
+        memdelete(E.value);
+    }
+    for (const KeyValue<uint64_t, ComponentTemplate *> &E : component_templates) {
+        if (E.value) {
+            memdelete(E.value);
+        }
+    }
 }
 
 GECS *GECS::get_singleton() {
@@ -54,6 +67,9 @@ void GECS::_bind_methods() {
     ADD_SIGNAL(MethodInfo("world_changed", PropertyInfo(Variant::OBJECT, "world")));
     ADD_SIGNAL(MethodInfo("world_exited"));
 
+    ClassDB::bind_static_method("GECS", D_METHOD("get_component_type_id", "component_type"), &GECS::get_component_type_id);
+    ClassDB::bind_static_method("GECS", D_METHOD("get_component_type_path", "id"), &GECS::get_component_type_path);
+    ClassDB::bind_static_method("GECS", D_METHOD("get_component_type_count"), &GECS::get_component_type_count);
     ClassDB::bind_static_method("GECS", D_METHOD("intersect", "array1", "array2"), &GECS::intersect);
     ClassDB::bind_static_method("GECS", D_METHOD("union_arrays", "array1", "array2"), &GECS::union_arrays);
     ClassDB::bind_static_method("GECS", D_METHOD("difference", "array1", "array2"), &GECS::difference);
@@ -128,13 +144,234 @@ Array GECS::get_components(const Array &entities, const Ref<Script> &component_t
     return components;
 }
 
+int GECS::get_component_type_id(const Ref<Resource> &p_type) {
+    return get_component_type_id_for_object(p_type.ptr());
+}
+
+int GECS::get_component_type_id_for_object(Object *p_type) {
+    if (!p_type || !singleton) {
+        return -1;
+    }
+    {
+        std::shared_lock<std::shared_mutex> lock(singleton->component_types_mutex);
+        const int *id = singleton->component_type_ids.getptr(p_type->get_instance_id());
+        if (id) {
+            return *id;
+        }
+    }
+    Component *component = Object::cast_to<Component>(p_type);
+    if (component) {
+        return component->get_type_id();
+    }
+    // Only scripts that extend Component get an ID; anything else would leave a stray registry entry.
+    Script *script = Object::cast_to<Script>(p_type);
+    if (!script || !ClassDBSingleton::get_singleton()->is_parent_class(script->get_instance_base_type(), Component::get_class_static())) {
+        return -1;
+    }
+    return singleton->_register_component_type(script);
+}
+
+int GECS::_register_component_type(Script *p_type) {
+    String path = p_type->get_path();
+
+    std::unique_lock<std::shared_mutex> lock(component_types_mutex);
+    // Another thread may have registered it since the shared lookup.
+    const int *registered = component_type_ids.getptr(p_type->get_instance_id());
+    if (registered) {
+        return *registered;
+    }
+    int id;
+    const int *existing = path.is_empty() ? nullptr : component_type_ids_by_path.getptr(path);
+    if (existing) {
+        // Same script reloaded under a new object: keep the ID stable.
+        id = *existing;
+    } else {
+        id = component_type_paths.size();
+        component_type_paths.push_back(path);
+        if (!path.is_empty()) {
+            component_type_ids_by_path[path] = id;
+        }
+    }
+    component_type_ids[p_type->get_instance_id()] = id;
+    return id;
+}
+
+String GECS::get_component_type_path(int p_id) {
+    if (!singleton) {
+        return String();
+    }
+    std::shared_lock<std::shared_mutex> lock(singleton->component_types_mutex);
+    if (p_id < 0 || p_id >= (int)singleton->component_type_paths.size()) {
+        return String();
+    }
+    return singleton->component_type_paths[p_id];
+}
+
+int GECS::get_component_type_count() {
+    if (!singleton) {
+        return 0;
+    }
+    std::shared_lock<std::shared_mutex> lock(singleton->component_types_mutex);
+    return (int)singleton->component_type_paths.size();
+}
+
+const QueryPlan *GECS::get_query_plan(const String &p_query) {
+    if (!singleton) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(singleton->query_plans_mutex);
+    QueryPlan **cached = singleton->query_plans.getptr(p_query);
+    if (cached) {
+        return *cached;
+    }
+    QueryPlan *plan = QueryPlan::parse(p_query);
+    if (!plan->valid) {
+        UtilityFunctions::push_error("Invalid query '" + p_query + "': " + plan->error);
+    }
+    singleton->query_plans.insert(p_query, plan);
+    return plan;
+}
+
+const ComponentTemplate *GECS::get_component_template(const Ref<Component> &p_component) {
+    // Only saved resources (files and scene sub-resources) are treated as fixed
+    // templates; ones built in code may still be edited between instances.
+    if (!singleton || p_component->get_path().is_empty()) {
+        return nullptr;
+    }
+    uint64_t id = p_component->get_instance_id();
+    ComponentTemplate **cached = singleton->component_templates.getptr(id);
+    if (cached) {
+        return *cached;
+    }
+
+    if (singleton->component_templates.size() >= singleton->component_templates_sweep_size) {
+        LocalVector<uint64_t> freed;
+        for (const KeyValue<uint64_t, ComponentTemplate *> &E : singleton->component_templates) {
+            if (!ObjectDB::get_instance(E.key)) {
+                freed.push_back(E.key);
+            }
+        }
+        for (uint32_t i = 0; i < freed.size(); i++) {
+            singleton->_drop_component_template(freed[i]);
+        }
+        singleton->component_templates_sweep_size = MAX(64u, singleton->component_templates.size() * 2);
+    }
+
+    ComponentTemplate *component_template = memnew(ComponentTemplate);
+    if (!component_template->build(p_component)) {
+        memdelete(component_template);
+        component_template = nullptr;
+    }
+    singleton->component_templates.insert(id, component_template);
+    p_component->connect("changed", callable_mp(singleton, &GECS::_on_component_template_changed).bind(id));
+    p_component->connect("property_changed", callable_mp(singleton, &GECS::_on_component_template_property_changed).bind(id));
+    return component_template;
+}
+
+void GECS::_drop_component_template(uint64_t p_id) {
+    ComponentTemplate **cached = component_templates.getptr(p_id);
+    if (!cached) return;
+    if (*cached) {
+        memdelete(*cached);
+    }
+    component_templates.erase(p_id);
+
+    Object *component = ObjectDB::get_instance(p_id);
+    if (component) {
+        component->disconnect("changed", callable_mp(this, &GECS::_on_component_template_changed).bind(p_id));
+        component->disconnect("property_changed", callable_mp(this, &GECS::_on_component_template_property_changed).bind(p_id));
+    }
+}
+
+void GECS::_on_component_template_changed(uint64_t p_id) {
+    _drop_component_template(p_id);
+}
+
+void GECS::_on_component_template_property_changed(Object *p_component, const String &p_property, const Variant &p_old_value, const Variant &p_new_value, uint64_t p_id) {
+    _drop_component_template(p_id);
+}
+
+// Set algebra over Arrays. Arrays of Objects (the common case: query results)
+// are reduced to ObjectIDs sorted with their original positions, merged, and
+// the kept positions collected in a bitset so results keep the input order.
+// Anything else falls back to hashing the Variants.
+namespace {
+
+struct IdEntry {
+    uint64_t id;
+    uint32_t position;
+
+    bool operator<(const IdEntry &p_other) const {
+        return id < p_other.id || (id == p_other.id && position < p_other.position);
+    }
+};
+
+bool _collect_ids(const Array &p_array, uint32_t p_offset, LocalVector<IdEntry> &r_entries) {
+    for (int64_t i = 0; i < p_array.size(); ++i) {
+        const Variant &element = p_array[i];
+        Object *object = element.get_type() == Variant::OBJECT ? (Object *)element : nullptr;
+        if (!object) {
+            return false;
+        }
+        IdEntry entry;
+        entry.id = object->get_instance_id();
+        entry.position = p_offset + i;
+        r_entries.push_back(entry);
+    }
+    return true;
+}
+
+// Sets r_matched for every entry of p_entries whose ID also occurs in p_other.
+void _mark_matches(const LocalVector<IdEntry> &p_entries, const LocalVector<IdEntry> &p_other, DenseBitset &r_matched) {
+    uint32_t j = 0;
+    for (uint32_t i = 0; i < p_entries.size(); ++i) {
+        uint64_t id = p_entries[i].id;
+        while (j < p_other.size() && p_other[j].id < id) {
+            j++;
+        }
+        if (j == p_other.size()) {
+            break;
+        }
+        if (p_other[j].id == id) {
+            r_matched.set(p_entries[i].position);
+        }
+    }
+}
+
+Array _gather(const Array &p_first, const Array &p_second, const DenseBitset &p_keep) {
+    Array result;
+    result.resize(p_keep.count());
+    int64_t index = 0;
+    uint32_t first_size = p_first.size();
+    for (uint32_t i = 0; i < p_keep.size(); ++i) {
+        if (p_keep.has(i)) {
+            result[index++] = i < first_size ? p_first[i] : p_second[i - first_size];
+        }
+    }
+    return result;
+}
+
+}
+
 Array GECS::intersect(const Array &array1, const Array &array2) {
     const Array &small_array = array1.size() < array2.size() ? array1 : array2;
     const Array &large_array = array1.size() < array2.size() ? array2 : array1;
 
-    Dictionary lookup;
+    LocalVector<IdEntry> small_ids;
+    LocalVector<IdEntry> large_ids;
+    if (_collect_ids(small_array, 0, small_ids) && _collect_ids(large_array, 0, large_ids)) {
+        small_ids.sort();
+        large_ids.sort();
+        DenseBitset matched;
+        matched.resize(small_array.size());
+        _mark_matches(small_ids, large_ids, matched);
+        return _gather(small_array, Array(), matched);
+    }
+
+    HashSet<Variant, VariantHasher, VariantComparator> lookup;
+    lookup.reserve(large_array.size());
     for (int i = 0; i < large_array.size(); ++i) {
-        lookup[large_array[i]] = true;
+        lookup.insert(large_array[i]);
     }
 
     Array result;
@@ -147,12 +384,27 @@ Array GECS::intersect(const Array &array1, const Array &array2) {
 }
 
 Array GECS::union_arrays(const Array &array1, const Array &array2) {
-    Dictionary seen;
+    LocalVector<IdEntry> ids;
+    if (_collect_ids(array1, 0, ids) && _collect_ids(array2, array1.size(), ids)) {
+        ids.sort();
+        // Keep the first occurrence of every ID; equal IDs sort by position.
+        DenseBitset keep;
+        keep.resize(array1.size() + array2.size());
+        for (uint32_t i = 0; i < ids.size(); ++i) {
+            if (i == 0 || ids[i].id != ids[i - 1].id) {
+                keep.set(ids[i].position);
+            }
+        }
+        return _gather(array1, array2, keep);
+    }
+
+    HashSet<Variant, VariantHasher, VariantComparator> seen;
+    seen.reserve(array1.size() + array2.size());
     Array result;
     for (int i = 0; i < array1.size(); ++i) {
         Variant item = array1[i];
         if (!seen.has(item)) {
-            seen[item] = true;
+            seen.insert(item);
             result.push_back(item);
         }
     }
@@ -160,7 +412,7 @@ Array GECS::union_arrays(const Array &array1, const Array &array2) {
     for (int i = 0; i < array2.size(); ++i) {
         Variant item = array2[i];
         if (!seen.has(item)) {
-            seen[item] = true;
+            seen.insert(item);
             result.push_back(item);
         }
     }
@@ -169,9 +421,24 @@ Array GECS::union_arrays(const Array &array1, const Array &array2) {
 }
 
 Array GECS::difference(const Array &array1, const Array &array2) {
-    Dictionary lookup;
+    LocalVector<IdEntry> ids;
+    LocalVector<IdEntry> removed_ids;
+    if (_collect_ids(array1, 0, ids) && _collect_ids(array2, 0, removed_ids)) {
+        ids.sort();
+        removed_ids.sort();
+        DenseBitset keep;
+        keep.resize(array1.size(), true);
+        DenseBitset removed;
+        removed.resize(array1.size());
+        _mark_matches(ids, removed_ids, removed);
+        keep.and_not(removed);
+        return _gather(array1, Array(), keep);
+    }
+
+    HashSet<Variant, VariantHasher, VariantComparator> lookup;
+    lookup.reserve(array2.size());
     for (int i = 0; i < array2.size(); ++i) {
-        lookup[array2[i]] = true;
+        lookup.insert(array2[i]);
     }
 
     Array result;
@@ -21,6 +21,17 @@ void Observer::set_q(const Ref<QueryBuilder>& p_q) {
     q = p_q;
 }
 
+int Observer::_resolve() {
+    match_query = match();
+    Ref<Resource> watch_script = watch();
+    watch_type_id = watch_script.is_valid() ? GECS::get_component_type_id(watch_script) : -1;
+    return watch_type_id;
+}
+
+bool Observer::_matches(Entity *entity) const {
+    return match_query.is_valid() && match_query->_matches_entity(entity);
+}
+
 Ref<QueryBuilder> Observer::match() {
     if (has_method("match")) {
         return call("match");
@@ -0,0 +1,95 @@
+#include "observer_queue.h"
+
+using namespace godot;
+
+ObserverEventQueue::ObserverEventQueue(uint32_t p_capacity) {
+    uint32_t capacity = 2;
+    while (capacity < p_capacity) {
+        capacity <<= 1;
+    }
+    ring.resize(capacity);
+}
+
+ObserverEventQueue::Event &ObserverEventQueue::_push_slot() {
+    if (count == ring.size()) {
+        // Re-slot the queued events by sequence number into a ring twice the size.
+        LocalVector<Event> grown;
+        grown.resize(ring.size() * 2);
+        for (uint64_t sequence = head; sequence < head + count; sequence++) {
+            grown[sequence & (grown.size() - 1)] = _slot(sequence);
+        }
+        ring = grown;
+    }
+    return _slot(head + count++);
+}
+
+void ObserverEventQueue::push(EventType p_type, uint64_t p_entity, Component *p_component) {
+    Event &event = _push_slot();
+    event.type = p_type;
+    event.entity = p_entity;
+    event.component = Ref<Component>(p_component);
+}
+
+void ObserverEventQueue::push_changed(uint64_t p_entity, Component *p_component, const StringName &p_property, const Variant &p_old_value, const Variant &p_new_value) {
+    ChangeKey key;
+    if (coalescing) {
+        key.entity = p_entity;
+        key.component = p_component->get_instance_id();
+        key.property = p_property;
+        const uint64_t *queued = pending_changes.getptr(key);
+        if (queued) {
+            _slot(*queued).new_value = p_new_value;
+            return;
+        }
+    }
+
+    uint64_t sequence = head + count;
+    Event &event = _push_slot();
+    event.type = COMPONENT_CHANGED;
+    event.entity = p_entity;
+    event.component = Ref<Component>(p_component);
+    event.property = p_property;
+    event.old_value = p_old_value;
+    event.new_value = p_new_value;
+    if (coalescing) {
+        pending_changes.insert(key, sequence);
+    }
+}
+
+bool ObserverEventQueue::pop(Event &r_event) {
+    if (count == 0) {
+        return false;
+    }
+    Event &event = _slot(head);
+    if (event.type == COMPONENT_CHANGED && !pending_changes.is_empty()) {
+        ChangeKey key;
+        key.entity = event.entity;
+        key.component = event.component.is_valid() ? event.component->get_instance_id() : 0;
+        key.property = event.property;
+        const uint64_t *queued = pending_changes.getptr(key);
+        if (queued && *queued == head) {
+            pending_changes.erase(key);
+        }
+    }
+    r_event = event;
+    // Drop the references now rather than when the slot is reused.
+    event = Event();
+    head++;
+    count--;
+    return true;
+}
+
+void ObserverEventQueue::clear() {
+    while (count > 0) {
+        _slot(head++) = Event();
+        count--;
+    }
+    pending_changes.clear();
+}
+
+void ObserverEventQueue::set_coalescing(bool p_coalescing) {
+    coalescing = p_coalescing;
+    if (!coalescing) {
+        pending_changes.clear();
+    }
+}
@@ -0,0 +1,124 @@
+#include "prefab.h"
+#include "component.h"
+#include "entity.h"
+
+#include <godot_cpp/core/class_db.hpp>
+#include <godot_cpp/variant/utility_functions.hpp>
+
+using namespace godot;
+
+bool ComponentTemplate::build(const Ref<Component> &p_component) {
+    script = p_component->get_script();
+    properties.clear();
+    values.clear();
+    if (script.is_null()) {
+        return false;
+    }
+
+    // Same property set Resource::duplicate() copies, minus what the constructor
+    // already sets. Compared against a constructed instance rather than the declared
+    // defaults, since _init() may assign something else.
+    Ref<Component> constructed = script->call("new");
+    TypedArray<Dictionary> props = script->get_script_property_list();
+    for (int i = 0; i < props.size(); i++) {
+        Dictionary p = props[i];
+        if (!(int(p["usage"]) & PROPERTY_USAGE_STORAGE)) continue;
+        StringName name = p["name"];
+        Variant value = p_component->get(name);
+        if (constructed.is_valid() && value == constructed->get(name)) continue;
+        properties.push_back(name);
+        values.push_back(value);
+    }
+    return true;
+}
+
+Ref<Component> ComponentTemplate::instantiate() const {
+    Ref<Component> component = script->call("new");
+    if (component.is_null()) {
+        return component;
+    }
+    for (uint32_t i = 0; i < properties.size(); i++) {
+        const Variant &value = values[i];
+        if (value.get_type() == Variant::ARRAY || value.get_type() == Variant::DICTIONARY) {
+            component->set(properties[i], value.duplicate());
+        } else {
+            component->set(properties[i], value);
+        }
+    }
+    return component;
+}
+
+void Prefab::_bind_methods() {
+    ClassDB::bind_method(D_METHOD("get_components"), &Prefab::get_components);
+    ClassDB::bind_method(D_METHOD("set_components", "p_value"), &Prefab::set_components);
+    ADD_PROPERTY(PropertyInfo(Variant::ARRAY, "components", PROPERTY_HINT_TYPE_STRING, "17/17:Component"), "set_components", "get_components");
+
+    ClassDB::bind_method(D_METHOD("get_shared_components"), &Prefab::get_shared_components);
+    ClassDB::bind_method(D_METHOD("set_shared_components", "p_value"), &Prefab::set_shared_components);
+    ADD_PROPERTY(PropertyInfo(Variant::ARRAY, "shared_components", PROPERTY_HINT_TYPE_STRING, "17/17:Component"), "set_shared_components", "get_shared_components");
+
+    ClassDB::bind_method(D_METHOD("add_component", "component", "shared"), &Prefab::add_component, DEFVAL(false));
+    ClassDB::bind_method(D_METHOD("instantiate", "entity"), &Prefab::instantiate, DEFVAL(Variant()));
+}
+
+void Prefab::_compile() {
+    templates.clear();
+    for (int i = 0; i < components.size(); i++) {
+        Ref<Component> component = components[i];
+        ComponentTemplate component_template;
+        if (component.is_null() || !component_template.build(component)) {
+            UtilityFunctions::push_error("Prefab components[" + String::num_int64(i) + "] must be a Component with a script.");
+            continue;
+        }
+        templates.push_back(component_template);
+    }
+    for (int i = 0; i < shared_components.size(); i++) {
+        Ref<Component> component = shared_components[i];
+        if (component.is_valid()) {
+            component->_set_shared(true);
+        }
+    }
+    compiled = true;
+}
+
+void Prefab::set_components(const TypedArray<Component> &p_components) {
+    components = p_components;
+    compiled = false;
+}
+
+TypedArray<Component> Prefab::get_components() const {
+    return components;
+}
+
+void Prefab::set_shared_components(const TypedArray<Component> &p_components) {
+    shared_components = p_components;
+    compiled = false;
+}
+
+TypedArray<Component> Prefab::get_shared_components() const {
+    return shared_components;
+}
+
+void Prefab::add_component(const Ref<Component> &p_component, bool p_shared) {
+    if (p_component.is_null()) return;
+    if (p_shared) {
+        shared_components.push_back(p_component);
+    } else {
+        components.push_back(p_component);
+    }
+    compiled = false;
+}
+
+Entity *Prefab::instantiate(Entity *p_entity) {
+    if (!compiled) {
+        _compile();
+    }
+    Entity *entity = p_entity ? p_entity : memnew(Entity);
+    for (uint32_t i = 0; i < templates.size(); i++) {
+        entity->add_component(templates[i].instantiate());
+    }
+    for (int i = 0; i < shared_components.size(); i++) {
+        entity->add_component(shared_components[i]);
+    }
+    return entity;
+}
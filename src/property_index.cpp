@@ -0,0 +1,126 @@
+#include "property_index.h"
+
+using namespace godot;
+
+static _FORCE_INLINE_ bool _is_number(const Variant &p_value) {
+    return p_value.get_type() == Variant::INT || p_value.get_type() == Variant::FLOAT;
+}
+
+PropertyIndex::PropertyIndex(int p_type_id, const StringName &p_property) {
+    type_id = p_type_id;
+    property = p_property;
+}
+
+void PropertyIndex::set(Entity *p_entity, const Variant &p_value) {
+    erase(p_entity);
+    if (!_is_number(p_value)) {
+        return;
+    }
+    Entry entry;
+    entry.value = p_value;
+    entry.entity = p_entity;
+    entries.insert(entry);
+    values.insert(p_entity, entry.value);
+}
+
+void PropertyIndex::erase(Entity *p_entity) {
+    const double *value = values.getptr(p_entity);
+    if (!value) {
+        return;
+    }
+    Entry entry;
+    entry.value = *value;
+    entry.entity = p_entity;
+    entries.erase(entry);
+    values.erase(p_entity);
+}
+
+void PropertyIndex::clear() {
+    entries.clear();
+    values.clear();
+}
+
+uint32_t PropertyIndex::size() const {
+    return values.size();
+}
+
+bool PropertyIndex::collect(const LocalVector<ComponentPredicate::Test> &p_tests, LocalVector<Entity *> &r_entities) const {
+    bool has_from = false, has_to = false;
+    bool from_inclusive = true, to_inclusive = true;
+    double from = 0.0, to = 0.0;
+    const ComponentPredicate::Test *points = nullptr;
+
+    for (uint32_t i = 0; i < p_tests.size(); i++) {
+        const ComponentPredicate::Test &test = p_tests[i];
+        if (test.op == ComponentPredicate::OP_IN) {
+            bool numeric = true;
+            for (uint32_t j = 0; j < test.operands.size() && numeric; j++) {
+                numeric = _is_number(test.operands[j]);
+            }
+            if (numeric && !points) {
+                points = &test;
+            }
+            continue;
+        }
+        if (!_is_number(test.operand)) {
+            continue;
+        }
+        double value = test.operand;
+        bool lower = test.op == ComponentPredicate::OP_EQ || test.op == ComponentPredicate::OP_GT || test.op == ComponentPredicate::OP_GTE;
+        bool upper = test.op == ComponentPredicate::OP_EQ || test.op == ComponentPredicate::OP_LT || test.op == ComponentPredicate::OP_LTE;
+        if (lower && (!has_from || value > from || (value == from && test.op == ComponentPredicate::OP_GT))) {
+            from = value;
+            from_inclusive = test.op != ComponentPredicate::OP_GT;
+            has_from = true;
+        }
+        if (upper && (!has_to || value < to || (value == to && test.op == ComponentPredicate::OP_LT))) {
+            to = value;
+            to_inclusive = test.op != ComponentPredicate::OP_LT;
+            has_to = true;
+        }
+    }
+
+    if (points) {
+        LocalVector<double> sorted;
+        for (uint32_t i = 0; i < points->operands.size(); i++) {
+            sorted.push_back(points->operands[i]);
+        }
+        sorted.sort();
+        for (uint32_t i = 0; i < sorted.size(); i++) {
+            double value = sorted[i];
+            if (i > 0 && value == sorted[i - 1]) continue;
+            if (has_from && (value < from || (value == from && !from_inclusive))) continue;
+            if (has_to && (value > to || (value == to && !to_inclusive))) continue;
+            _collect_range(true, value, true, true, value, true, r_entities);
+        }
+        return true;
+    }
+    if (!has_from && !has_to) {
+        return false;
+    }
+    if (has_from && has_to && from > to) {
+        return true;
+    }
+
+    _collect_range(has_from, from, from_inclusive, has_to, to, to_inclusive, r_entities);
+    return true;
+}
+
+void PropertyIndex::_collect_range(bool p_has_from, double p_from, bool p_from_inclusive, bool p_has_to, double p_to, bool p_to_inclusive, LocalVector<Entity *> &r_entities) const {
+    const RBSet<Entry>::Element *E = entries.front();
+    if (p_has_from) {
+        Entry first;
+        first.value = p_from;
+        E = entries.lower_bound(first);
+        while (E && !p_from_inclusive && E->get().value == p_from) {
+            E = E->next();
+        }
+    }
+    for (; E; E = E->next()) {
+        double value = E->get().value;
+        if (p_has_to && (value > p_to || (value == p_to && !p_to_inclusive))) {
+            break;
+        }
+        r_entities.push_back(E->get().entity);
+    }
+}
@@ -3,7 +3,12 @@
 #include "entity.h"
 #include "component.h"
 #include "relationship.h"
+#include "relationship_index.h"
+#include "gecs.h"
+#include "query_plan.h"
+#include <godot_cpp/classes/scene_tree.hpp>
 #include <godot_cpp/core/class_db.hpp>
+#include <godot_cpp/templates/hash_set.hpp>
 #include <godot_cpp/variant/utility_functions.hpp>
 
 using namespace godot;
@@ -21,6 +26,8 @@ void QueryBuilder::_bind_methods() {
     ClassDB::bind_method(D_METHOD("with_group", "groups"), &QueryBuilder::with_group);
     ClassDB::bind_method(D_METHOD("without_group", "groups"), &QueryBuilder::without_group);
     ClassDB::bind_method(D_METHOD("with_reverse_relationship", "relationships"), &QueryBuilder::with_reverse_relationship);
+    ClassDB::bind_method(D_METHOD("with_changed", "components"), &QueryBuilder::with_changed);
+    ClassDB::bind_method(D_METHOD("with_added", "components"), &QueryBuilder::with_added);
     
     ClassDB::bind_method(D_METHOD("execute_one"), &QueryBuilder::execute_one);
     ClassDB::bind_method(D_METHOD("clear"), &QueryBuilder::clear);
@@ -28,6 +35,7 @@ void QueryBuilder::_bind_methods() {
     ClassDB::bind_method(D_METHOD("is_empty"), &QueryBuilder::is_empty);
     ClassDB::bind_method(D_METHOD("as_array"), &QueryBuilder::as_array);
     ClassDB::bind_method(D_METHOD("compile", "query"), &QueryBuilder::compile);
+    ClassDB::bind_method(D_METHOD("explain"), &QueryBuilder::explain);
 
     GDVIRTUAL_BIND(execute);
     GDVIRTUAL_BIND(matches, "entities");
@@ -81,39 +89,303 @@ QueryBuilder* QueryBuilder::without_group(const Array &p_groups) {
 }
 
 QueryBuilder* QueryBuilder::with_reverse_relationship(const Array &p_relationships) {
-    for (int i = 0; i < p_relationships.size(); i++) {
-        Variant rel_var = p_relationships[i];
-        if (rel_var.get_type() == Variant::OBJECT) {
-            Ref<Relationship> rel = rel_var;
-            if (rel.is_valid() && rel->get_relation().is_valid()) {
-                Ref<Script> rel_script = rel->get_relation()->get_script();
-                if (rel_script.is_valid()) {
-                    String rev_key = "reverse_" + rel_script->get_path();
-                    if (world && world->reverse_relationship_index.has(rev_key)) {
-                    }
-                }
-            }
-        }
-    }
+    reverse_relationships = p_relationships;
     invalidate_cache();
     return this;
 }
 
+QueryBuilder* QueryBuilder::with_changed(const Array &p_components) {
+    changed_components = p_components;
+    invalidate_cache();
+    return this;
+}
+
+QueryBuilder* QueryBuilder::with_added(const Array &p_components) {
+    added_components = p_components;
+    invalidate_cache();
+    return this;
+}
+
+void QueryBuilder::_set_change_since(uint64_t p_tick) {
+    change_since = p_tick;
+}
+
 QueryBuilder* QueryBuilder::clear() {
     all_components.clear();
     any_components.clear();
     none_components.clear();
     relationships.clear();
     exclude_relationships.clear();
+    reverse_relationships.clear();
     groups.clear();
     exclude_groups.clear();
+    changed_components.clear();
+    added_components.clear();
+    match_nothing = false;
     invalidate_cache();
     return this;
 }
 
 void QueryBuilder::invalidate_cache() {
     cache_valid = false;
-    cached_result.clear();
+    query_key_valid = false;
+    compiled_plan = nullptr;
+    // The result may be shared with the world's cache, so drop the reference instead of clearing it.
+    cached_result = Array();
+}
+
+const World::QueryCacheKey &QueryBuilder::_get_query_key() {
+    if (!query_key_valid) {
+        query_key = World::QueryCacheKey();
+        World::_make_query_key(all_components, any_components, none_components, query_key);
+
+        all_predicates.clear();
+        any_predicates.clear();
+        watched_properties.clear();
+        _compile_predicates(all_components, false, all_predicates);
+        _compile_predicates(any_components, true, any_predicates);
+        _compile_relationships(relationships, relationship_terms);
+        _compile_relationships(exclude_relationships, exclude_relationship_terms);
+        _compile_relationships(reverse_relationships, reverse_relationship_terms);
+
+        // Only entities that have a component can have changed it.
+        changed_type_ids.clear();
+        added_type_ids.clear();
+        for (int i = 0; i < changed_components.size(); i++) {
+            int type_id = GECS::get_component_type_id_for_object(changed_components[i]);
+            if (type_id < 0) continue;
+            changed_type_ids.push_back(type_id);
+            query_key.all.set(type_id);
+        }
+        for (int i = 0; i < added_components.size(); i++) {
+            int type_id = GECS::get_component_type_id_for_object(added_components[i]);
+            if (type_id < 0) continue;
+            added_type_ids.push_back(type_id);
+            query_key.all.set(type_id);
+        }
+        query_key_valid = true;
+    }
+    return query_key;
+}
+
+void QueryBuilder::_compile_predicates(const Array &p_components, bool p_any, LocalVector<ComponentPredicate> &r_predicates) {
+    bool has_tests = false;
+    for (int i = 0; i < p_components.size(); i++) {
+        Variant element = p_components[i];
+        if (element.get_type() != Variant::DICTIONARY) {
+            // Plain types only matter as with_any alternatives next to value terms.
+            if (p_any) {
+                ComponentPredicate predicate;
+                predicate.type_id = GECS::get_component_type_id_for_object(element);
+                r_predicates.push_back(predicate);
+            }
+            continue;
+        }
+
+        Dictionary query = element;
+        Array types = query.keys();
+        for (int j = 0; j < types.size(); j++) {
+            Variant property_query = query[types[j]];
+            ComponentPredicate predicate;
+            predicate.compile(GECS::get_component_type_id_for_object(types[j]), property_query.get_type() == Variant::DICTIONARY ? Dictionary(property_query) : Dictionary());
+            if (!predicate.has_tests() && !p_any) {
+                continue;
+            }
+            for (uint32_t k = 0; k < predicate.properties.size(); k++) {
+                World::PropertyKey key;
+                key.type_id = predicate.type_id;
+                key.property = predicate.properties[k].property;
+                watched_properties.push_back(key);
+                if (world) {
+                    world->_watch_property(key);
+                }
+            }
+            has_tests = has_tests || predicate.has_tests();
+            r_predicates.push_back(predicate);
+        }
+    }
+    if (p_any && !has_tests) {
+        // The component mask already answers presence-only with_any.
+        r_predicates.clear();
+    }
+}
+
+void QueryBuilder::_compile_relationships(const Array &p_relationships, LocalVector<RelationshipTerm> &r_terms) {
+    r_terms.clear();
+    for (int i = 0; i < p_relationships.size(); i++) {
+        Ref<Relationship> relationship = p_relationships[i];
+        if (relationship.is_null()) continue;
+        RelationshipTerm term;
+        term.relationship = relationship;
+        term.type_id = RelationshipIndex::relation_type(relationship);
+        term.target = RelationshipIndex::target_key(relationship);
+
+        // Component::equals() compares every script property, or defers to a script override.
+        bool compares_values = true;
+        Ref<Script> script = term.type_id >= 0 ? Ref<Script>(relationship->get_relation()->get_script()) : Ref<Script>();
+        if (script.is_valid() && !script->has_method("equals")) {
+            compares_values = false;
+            TypedArray<Dictionary> props = script->get_script_property_list();
+            for (int p = 0; p < props.size() && !compares_values; p++) {
+                Dictionary prop = props[p];
+                compares_values = int(prop["usage"]) & PROPERTY_USAGE_STORAGE;
+            }
+        }
+        Object *target = relationship->get_target();
+        term.exact = !compares_values && !(target && Object::cast_to<Script>(target));
+        r_terms.push_back(term);
+    }
+}
+
+bool QueryBuilder::_has_relationship(Entity *entity, const RelationshipTerm &p_term) const {
+    const RelationshipIndex &index = world->_get_relationship_index();
+    if (p_term.type_id < 0 || index.get_untyped().has(entity)) {
+        return entity->has_relationship(p_term.relationship);
+    }
+    bool hit = p_term.target ? index.has(p_term.type_id, p_term.target, entity) : index.has(p_term.type_id, entity);
+    if (hit) {
+        return p_term.exact || entity->has_relationship(p_term.relationship);
+    }
+    // Relationships of this type to a null or script target may still match an entity target.
+    return p_term.target && index.has(p_term.type_id, 0, entity) && entity->has_relationship(p_term.relationship);
+}
+
+static uint64_t _script_id(Object *p_object) {
+    Ref<Script> script = p_object->get_script();
+    return script.is_valid() ? script->get_instance_id() : 0;
+}
+
+// Whether entity is the target of a relationship matching p_term's relation.
+// A relationship targeting a script targets every entity of that script,
+// its own source included. p_term's own target, when set, narrows which
+// entities qualify.
+bool QueryBuilder::_is_relationship_target(Entity *entity, const RelationshipTerm &p_term) const {
+    Object *filter = p_term.relationship->get_target();
+    if (filter && filter != entity) {
+        Script *filter_script = Object::cast_to<Script>(filter);
+        if (!filter_script || filter_script->get_instance_id() != _script_id(entity)) {
+            return false;
+        }
+    }
+
+    const RelationshipIndex &index = world->_get_relationship_index();
+    uint64_t id = entity->get_instance_id();
+    if (!index.is_target(p_term.type_id, id, _script_id(entity))) {
+        return false;
+    }
+    if (p_term.exact || p_term.type_id < 0) {
+        return true;
+    }
+
+    // The relation's values must match too: ask the sources pointing here.
+    Ref<Relationship> probe;
+    probe.instantiate();
+    probe->_init(p_term.relationship->get_relation(), entity);
+    const RelationshipIndex::SourceSet *sources[] = { index.get_sources(p_term.type_id, id), index.get_sources(p_term.type_id, 0) };
+    for (const RelationshipIndex::SourceSet *set : sources) {
+        if (!set) continue;
+        for (const KeyValue<Entity *, uint32_t> &E : *set) {
+            if (E.key->has_relationship(probe)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// Entities that may satisfy p_term as a reverse relationship. Returns false
+// when script targets make them impossible to list without a scan.
+bool QueryBuilder::_collect_relationship_targets(const RelationshipTerm &p_term, LocalVector<Entity *> *r_entities, int64_t &r_count) const {
+    if (p_term.target) {
+        // Only the named entity can qualify.
+        Entity *entity = Object::cast_to<Entity>(ObjectDB::get_instance(p_term.target));
+        r_count = entity ? 1 : 0;
+        if (entity && r_entities) {
+            r_entities->push_back(entity);
+        }
+        return true;
+    }
+    const RelationshipIndex &index = world->_get_relationship_index();
+    const RelationshipIndex::Targets *typed = index.get_targets(p_term.type_id);
+    const RelationshipIndex::Targets *untyped = p_term.type_id >= 0 ? index.get_untyped_targets() : nullptr;
+    if ((typed && !typed->scripts.is_empty()) || (untyped && !untyped->scripts.is_empty())) {
+        return false;
+    }
+    r_count = (typed ? typed->entities.size() : 0) + (untyped ? untyped->entities.size() : 0);
+    if (!r_entities) {
+        return true;
+    }
+    HashSet<uint64_t> seen;
+    const RelationshipIndex::Targets *sets[] = { typed, untyped };
+    for (const RelationshipIndex::Targets *targets : sets) {
+        if (!targets) continue;
+        for (const KeyValue<uint64_t, uint32_t> &E : targets->entities) {
+            if (seen.has(E.key)) continue;
+            seen.insert(E.key);
+            Entity *entity = Object::cast_to<Entity>(ObjectDB::get_instance(E.key));
+            if (entity) {
+                r_entities->push_back(entity);
+            }
+        }
+    }
+    return true;
+}
+
+// Sources that may satisfy p_term, as a superset of the real matches. Returns
+// false when the index can't bound them (null relation, or untyped relationships exist).
+bool QueryBuilder::_collect_relationship_sources(const RelationshipTerm &p_term, LocalVector<Entity *> *r_entities, int64_t &r_count) const {
+    const RelationshipIndex &index = world->_get_relationship_index();
+    if (p_term.type_id < 0 || !index.get_untyped().is_empty()) {
+        return false;
+    }
+    const RelationshipIndex::SourceSet *sources = index.get_sources(p_term.type_id, p_term.target);
+    const RelationshipIndex::SourceSet *loose = p_term.target ? index.get_sources(p_term.type_id, 0) : nullptr;
+    r_count = (sources ? sources->size() : 0) + (loose ? loose->size() : 0);
+    if (!r_entities) {
+        return true;
+    }
+    if (sources) {
+        for (const KeyValue<Entity *, uint32_t> &E : *sources) {
+            r_entities->push_back(E.key);
+        }
+    }
+    if (loose) {
+        for (const KeyValue<Entity *, uint32_t> &E : *loose) {
+            if (!sources || !sources->has(E.key)) {
+                r_entities->push_back(E.key);
+            }
+        }
+    }
+    return true;
+}
+
+uint64_t QueryBuilder::_get_property_version() const {
+    uint64_t version = 0;
+    for (uint32_t i = 0; i < watched_properties.size(); i++) {
+        version = MAX(version, world->_get_property_version(watched_properties[i]));
+    }
+    return version;
+}
+
+bool QueryBuilder::_matches_values(Entity *entity) const {
+    for (uint32_t i = 0; i < all_predicates.size(); i++) {
+        const ComponentPredicate &predicate = all_predicates[i];
+        Ref<Component> component = entity->get_component_by_type_id(predicate.type_id);
+        if (component.is_null() || !predicate.evaluate(component.ptr())) {
+            return false;
+        }
+    }
+    if (any_predicates.is_empty()) {
+        return true;
+    }
+    for (uint32_t i = 0; i < any_predicates.size(); i++) {
+        const ComponentPredicate &predicate = any_predicates[i];
+        Ref<Component> component = entity->get_component_by_type_id(predicate.type_id);
+        if (component.is_valid() && predicate.evaluate(component.ptr())) {
+            return true;
+        }
+    }
+    return false;
 }
 
 Array QueryBuilder::execute() {
@@ -122,15 +394,48 @@ Array QueryBuilder::execute() {
         return ret;
     }
     
-    if (cache_valid) {
-        return cached_result;
+    if (!world || match_nothing) {
+        return Array();
     }
-    if (world) {
-        cached_result = _internal_execute();
-        cache_valid = true;
+
+    uint64_t version = 0;
+    Array result = world->_query(_get_query_key(), &version);
+    uint64_t property_version = _get_property_version();
+    bool has_relationships = !relationship_terms.is_empty() || !exclude_relationship_terms.is_empty() || !reverse_relationship_terms.is_empty();
+    uint64_t relationship_version = has_relationships ? world->_get_relationship_version() : 0;
+    // Change filters depend on ticks no version tracks, so they always rerun.
+    bool tracks_changes = !changed_type_ids.is_empty() || !added_type_ids.is_empty();
+    if (!tracks_changes && cache_valid && version == cached_version && property_version == cached_property_version && relationship_version == cached_relationship_version) {
         return cached_result;
     }
-    return Array();
+    cached_result = _run_plan(result, nullptr);
+    cached_version = version;
+    cached_property_version = property_version;
+    cached_relationship_version = relationship_version;
+    cache_valid = true;
+    return cached_result;
+}
+
+// Whether execute() would include the entity, checked against that entity alone.
+bool QueryBuilder::_matches_entity(Entity *entity) {
+    if (!entity) {
+        return false;
+    }
+    if (GDVIRTUAL_IS_OVERRIDDEN(execute)) {
+        return execute().has(entity);
+    }
+    if (!world || match_nothing) {
+        return false;
+    }
+    _get_query_key();
+    return _passes_stage(STAGE_COMPONENTS, entity)
+            && _passes_stage(STAGE_VALUES, entity)
+            && (groups.is_empty() || _passes_stage(STAGE_GROUPS, entity))
+            && _passes_stage(STAGE_EXCLUDE_GROUPS, entity)
+            && _passes_stage(STAGE_RELATIONSHIPS, entity)
+            && _passes_stage(STAGE_EXCLUDE_RELATIONSHIPS, entity)
+            && _passes_stage(STAGE_REVERSE_RELATIONSHIPS, entity)
+            && _passes_stage(STAGE_CHANGES, entity);
 }
 
 Object* QueryBuilder::execute_one() {
@@ -141,74 +446,325 @@ Object* QueryBuilder::execute_one() {
     return nullptr;
 }
 
-Array QueryBuilder::_internal_execute() {
-    if (!world) {
-        return Array();
-    }
-    
-    Array result = world->_query(all_components, any_components, none_components);
-    if (relationships.is_empty() && exclude_relationships.is_empty() && groups.is_empty() && exclude_groups.is_empty()) {
-        return result;
-    }
-
-    Array filtered_result;
-    for (int i = 0; i < result.size(); ++i) {
-        Entity* entity = Object::cast_to<Entity>(result[i]);
-        if (!entity) continue;
-
-        bool match = true;
-        
-        if (!groups.is_empty()) {
-            bool in_any_group = false;
+bool QueryBuilder::_passes_stage(QueryStageType p_type, Entity *entity) const {
+    switch (p_type) {
+        case STAGE_COMPONENTS:
+            return entity->get_world() == world && query_key.matches(entity->get_signature());
+        case STAGE_VALUES:
+            return _matches_values(entity);
+        case STAGE_GROUPS:
             for (int g = 0; g < groups.size(); ++g) {
-                String group_name = groups[g];
-                if (entity->is_in_group(group_name)) {
-                    in_any_group = true;
-                    break;
+                if (entity->is_in_group(groups[g])) {
+                    return true;
                 }
             }
-            if (!in_any_group) match = false;
-        }
-        if (match && !exclude_groups.is_empty()) {
+            return false;
+        case STAGE_EXCLUDE_GROUPS:
             for (int g = 0; g < exclude_groups.size(); ++g) {
-                String group_name = exclude_groups[g];
-                if (entity->is_in_group(group_name)) {
-                    match = false;
-                    break;
+                if (entity->is_in_group(exclude_groups[g])) {
+                    return false;
+                }
+            }
+            return true;
+        case STAGE_RELATIONSHIPS:
+            for (uint32_t r = 0; r < relationship_terms.size(); ++r) {
+                if (!_has_relationship(entity, relationship_terms[r])) {
+                    return false;
+                }
+            }
+            return true;
+        case STAGE_EXCLUDE_RELATIONSHIPS:
+            for (uint32_t r = 0; r < exclude_relationship_terms.size(); ++r) {
+                if (_has_relationship(entity, exclude_relationship_terms[r])) {
+                    return false;
+                }
+            }
+            return true;
+        case STAGE_REVERSE_RELATIONSHIPS:
+            for (uint32_t r = 0; r < reverse_relationship_terms.size(); ++r) {
+                if (!_is_relationship_target(entity, reverse_relationship_terms[r])) {
+                    return false;
+                }
+            }
+            return true;
+        case STAGE_CHANGES:
+            // Passes when any listed component was changed (or added) after change_since.
+            if (changed_type_ids.is_empty() && added_type_ids.is_empty()) {
+                return true;
+            }
+            for (uint32_t i = 0; i < changed_type_ids.size(); i++) {
+                Ref<Component> component = entity->get_component_by_type_id(changed_type_ids[i]);
+                if (component.is_valid() && component->_get_changed_tick() > change_since) {
+                    return true;
                 }
             }
+            for (uint32_t i = 0; i < added_type_ids.size(); i++) {
+                Ref<Component> component = entity->get_component_by_type_id(added_type_ids[i]);
+                if (component.is_valid() && component->_get_added_tick() > change_since) {
+                    return true;
+                }
+            }
+            return false;
+    }
+    return false;
+}
+
+static const char *_source_name(int p_source) {
+    static const char *names[] = { "components", "property_index", "groups", "relationship_index", "reverse_relationship_index" };
+    return names[p_source];
+}
+
+static const char *_stage_name(int p_stage) {
+    static const char *names[] = { "components", "values", "groups", "exclude_groups", "relationships", "exclude_relationships", "changes", "reverse_relationships" };
+    return names[p_stage];
+}
+
+Array QueryBuilder::_run_plan(const Array &p_structural, Dictionary *r_explain) {
+    double total = MAX(world->get_entity_count(), 1);
+    bool has_values = !all_predicates.is_empty() || !any_predicates.is_empty();
+
+    // Pick the smallest candidate source: the cached structural result, an
+    // indexed value term, or the scene tree's group lists.
+    QuerySource source = SOURCE_COMPONENTS;
+    int64_t source_size = p_structural.size();
+    LocalVector<Entity *> candidates;
+    double value_selectivity = 0.5;
+    for (uint32_t i = 0; i < all_predicates.size(); i++) {
+        const ComponentPredicate &predicate = all_predicates[i];
+        for (uint32_t j = 0; j < predicate.properties.size(); j++) {
+            World::PropertyKey key;
+            key.type_id = predicate.type_id;
+            key.property = predicate.properties[j].property;
+            LocalVector<Entity *> indexed;
+            uint32_t index_size = 0;
+            if (!world->_collect_property_index(key, predicate.properties[j].tests, indexed, index_size)) continue;
+
+            value_selectivity = MIN(value_selectivity, double(indexed.size()) / MAX(index_size, 1u));
+            if (int64_t(indexed.size()) < source_size) {
+                source = SOURCE_PROPERTY_INDEX;
+                source_size = indexed.size();
+                candidates = indexed;
+            }
+        }
+    }
+
+    SceneTree *tree = world->get_tree();
+    double group_selectivity = 1.0;
+    if (!groups.is_empty() && tree) {
+        int64_t group_size = 0;
+        for (int g = 0; g < groups.size(); ++g) {
+            group_size += tree->get_node_count_in_group(groups[g]);
+        }
+        group_selectivity = MIN(group_size / total, 1.0);
+        if (group_size < source_size) {
+            source = SOURCE_GROUPS;
+            source_size = group_size;
+            candidates.clear();
+        }
+    }
+    double exclude_group_selectivity = 1.0;
+    if (!exclude_groups.is_empty() && tree) {
+        int64_t group_size = 0;
+        for (int g = 0; g < exclude_groups.size(); ++g) {
+            group_size += tree->get_node_count_in_group(exclude_groups[g]);
+        }
+        exclude_group_selectivity = MAX(1.0 - group_size / total, 0.0);
+    }
+
+    // Relationship terms narrow to their indexed sources, whose sizes also give real selectivities.
+    double relationship_selectivity = 1.0;
+    int64_t best_relationship = -1;
+    for (uint32_t r = 0; r < relationship_terms.size(); r++) {
+        int64_t count = 0;
+        if (!_collect_relationship_sources(relationship_terms[r], nullptr, count)) {
+            relationship_selectivity = MIN(relationship_selectivity, 0.5);
+            continue;
+        }
+        relationship_selectivity = MIN(relationship_selectivity, MIN(count / total, 1.0));
+        if (count < source_size) {
+            source = SOURCE_RELATIONSHIP_INDEX;
+            source_size = count;
+            best_relationship = r;
+        }
+    }
+    double reverse_selectivity = 1.0;
+    int64_t best_reverse = -1;
+    for (uint32_t r = 0; r < reverse_relationship_terms.size(); r++) {
+        int64_t count = 0;
+        if (!_collect_relationship_targets(reverse_relationship_terms[r], nullptr, count)) {
+            reverse_selectivity = MIN(reverse_selectivity, 0.5);
+            continue;
+        }
+        reverse_selectivity = MIN(reverse_selectivity, MIN(count / total, 1.0));
+        if (count < source_size) {
+            source = SOURCE_REVERSE_RELATIONSHIP_INDEX;
+            source_size = count;
+            best_reverse = r;
+        }
+    }
+    if (source == SOURCE_RELATIONSHIP_INDEX) {
+        int64_t count = 0;
+        candidates.clear();
+        _collect_relationship_sources(relationship_terms[best_relationship], &candidates, count);
+    } else if (source == SOURCE_REVERSE_RELATIONSHIP_INDEX) {
+        int64_t count = 0;
+        candidates.clear();
+        _collect_relationship_targets(reverse_relationship_terms[best_reverse], &candidates, count);
+    }
+    double exclude_relationship_selectivity = 1.0;
+    for (uint32_t r = 0; r < exclude_relationship_terms.size(); r++) {
+        int64_t count = 0;
+        if (!_collect_relationship_sources(exclude_relationship_terms[r], nullptr, count)) {
+            exclude_relationship_selectivity = MIN(exclude_relationship_selectivity, 0.5);
+            continue;
+        }
+        exclude_relationship_selectivity = MIN(exclude_relationship_selectivity, MAX(1.0 - count / total, 0.0));
+    }
+
+    LocalVector<QueryStage> stages;
+    if (source != SOURCE_COMPONENTS) {
+        QueryStage stage;
+        stage.type = STAGE_COMPONENTS;
+        stage.selectivity = MIN(p_structural.size() / total, 1.0);
+        stages.push_back(stage);
+    }
+    if (has_values) {
+        QueryStage stage;
+        stage.type = STAGE_VALUES;
+        stage.selectivity = value_selectivity;
+        stage.cost = 4.0 * (all_predicates.size() + any_predicates.size());
+        stages.push_back(stage);
+    }
+    if (!groups.is_empty() && source != SOURCE_GROUPS) {
+        QueryStage stage;
+        stage.type = STAGE_GROUPS;
+        stage.selectivity = group_selectivity;
+        stage.cost = 2.0 * groups.size();
+        stages.push_back(stage);
+    }
+    if (!exclude_groups.is_empty()) {
+        QueryStage stage;
+        stage.type = STAGE_EXCLUDE_GROUPS;
+        stage.selectivity = exclude_group_selectivity;
+        stage.cost = 2.0 * exclude_groups.size();
+        stages.push_back(stage);
+    }
+    // Indexed terms cost a set lookup; the rest (null relations) assume half survive.
+    if (!relationship_terms.is_empty()) {
+        QueryStage stage;
+        stage.type = STAGE_RELATIONSHIPS;
+        stage.selectivity = relationship_selectivity;
+        stage.cost = 2.0 * relationship_terms.size();
+        stages.push_back(stage);
+    }
+    if (!exclude_relationship_terms.is_empty()) {
+        QueryStage stage;
+        stage.type = STAGE_EXCLUDE_RELATIONSHIPS;
+        stage.selectivity = exclude_relationship_selectivity;
+        stage.cost = 2.0 * exclude_relationship_terms.size();
+        stages.push_back(stage);
+    }
+
+    if (!reverse_relationship_terms.is_empty()) {
+        QueryStage stage;
+        stage.type = STAGE_REVERSE_RELATIONSHIPS;
+        stage.selectivity = reverse_selectivity;
+        stage.cost = 2.0 * reverse_relationship_terms.size();
+        stages.push_back(stage);
+    }
+    // Most entities are untouched in any one frame.
+    if (!changed_type_ids.is_empty() || !added_type_ids.is_empty()) {
+        QueryStage stage;
+        stage.type = STAGE_CHANGES;
+        stage.selectivity = 0.1;
+        stage.cost = 2.0 * (changed_type_ids.size() + added_type_ids.size());
+        stages.push_back(stage);
+    }
+
+    // Order by how many candidates a stage drops per unit of work.
+    for (uint32_t i = 1; i < stages.size(); i++) {
+        QueryStage stage = stages[i];
+        double rank = (1.0 - stage.selectivity) / stage.cost;
+        uint32_t j = i;
+        while (j > 0 && (1.0 - stages[j - 1].selectivity) / stages[j - 1].cost < rank) {
+            stages[j] = stages[j - 1];
+            j--;
         }
+        stages[j] = stage;
+    }
 
-        if (match && !relationships.is_empty()) {
-            for (int r = 0; r < relationships.size(); ++r) {
-                Variant rel_var = relationships[r];
-                if (rel_var.get_type() == Variant::OBJECT) {
-                    Ref<Relationship> rel = rel_var;
-                    if (rel.is_valid() && !entity->has_relationship(rel)) {
-                        match = false;
-                        break;
+    Array result;
+    if (stages.is_empty()) {
+        result = p_structural;
+    } else {
+        if (source == SOURCE_COMPONENTS) {
+            candidates.resize(p_structural.size());
+            for (int64_t i = 0; i < p_structural.size(); i++) {
+                candidates[i] = Object::cast_to<Entity>(p_structural[i]);
+            }
+        } else if (source == SOURCE_GROUPS) {
+            HashSet<Entity *> seen;
+            for (int g = 0; g < groups.size(); ++g) {
+                TypedArray<Node> nodes = tree->get_nodes_in_group(groups[g]);
+                for (int64_t i = 0; i < nodes.size(); i++) {
+                    Entity *entity = Object::cast_to<Entity>(nodes[i]);
+                    if (entity && (groups.size() == 1 || !seen.has(entity))) {
+                        seen.insert(entity);
+                        candidates.push_back(entity);
                     }
                 }
             }
         }
-        if (match && !exclude_relationships.is_empty()) {
-            for (int r = 0; r < exclude_relationships.size(); ++r) {
-                Variant rel_var = exclude_relationships[r];
-                if (rel_var.get_type() == Variant::OBJECT) {
-                    Ref<Relationship> rel = rel_var;
-                    if (rel.is_valid() && entity->has_relationship(rel)) {
-                        match = false;
-                        break;
-                    }
+
+        for (uint32_t s = 0; s < stages.size(); s++) {
+            QueryStage &stage = stages[s];
+            stage.input = candidates.size();
+            uint32_t kept = 0;
+            for (uint32_t i = 0; i < candidates.size(); i++) {
+                if (candidates[i] && _passes_stage(stage.type, candidates[i])) {
+                    candidates[kept++] = candidates[i];
                 }
             }
+            candidates.resize(kept);
+            stage.output = kept;
+            if (kept == 0) {
+                break;
+            }
         }
-        
-        if (match) {
-            filtered_result.push_back(entity);
+
+        result.resize(candidates.size());
+        for (uint32_t i = 0; i < candidates.size(); i++) {
+            result[i] = candidates[i];
         }
     }
-    return filtered_result;
+
+    if (r_explain) {
+        Array stage_info;
+        for (uint32_t s = 0; s < stages.size(); s++) {
+            Dictionary info;
+            info["stage"] = _stage_name(stages[s].type);
+            info["selectivity"] = stages[s].selectivity;
+            info["cost"] = stages[s].cost;
+            info["input"] = stages[s].input;
+            info["output"] = stages[s].output;
+            stage_info.push_back(info);
+        }
+        (*r_explain)["source"] = _source_name(source);
+        (*r_explain)["source_size"] = source_size;
+        (*r_explain)["stages"] = stage_info;
+        (*r_explain)["result"] = result.size();
+    }
+    return result;
+}
+
+Dictionary QueryBuilder::explain() {
+    Dictionary plan;
+    if (!world) {
+        return plan;
+    }
+    Array structural = world->_query(_get_query_key());
+    _run_plan(structural, &plan);
+    return plan;
 }
 
 Array QueryBuilder::matches(const Array &p_entities) {
@@ -217,55 +773,20 @@ Array QueryBuilder::matches(const Array &p_entities) {
         return ret;
     }
     
+    if (match_nothing) {
+        return Array();
+    }
     if (is_empty()) {
         return p_entities;
     }
     
+    const World::QueryCacheKey &key = _get_query_key();
     Array result;
     for (int i = 0; i < p_entities.size(); i++) {
         Entity *entity = Object::cast_to<Entity>(p_entities[i]);
         if (!entity) continue;
-        
-        bool match = true;
-
-        for (int j = 0; j < all_components.size(); j++) {
-            Variant comp_var = all_components[j];
-            if (comp_var.get_type() == Variant::OBJECT) {
-                Ref<Resource> comp = comp_var;
-                if (comp.is_valid() && !entity->has_component(comp)) {
-                    match = false;
-                    break;
-                }
-            }
-        }
-        if (!match) continue;
-        if (!any_components.is_empty()) {
-            bool any_match = false;
-            for (int j = 0; j < any_components.size(); j++) {
-                Variant comp_var = any_components[j];
-                if (comp_var.get_type() == Variant::OBJECT) {
-                    Ref<Resource> comp = comp_var;
-                    if (comp.is_valid() && entity->has_component(comp)) {
-                        any_match = true;
-                        break;
-                    }
-                }
-            }
-            if (!any_match) match = false;
-        }
-        if (!match) continue;
-        for (int j = 0; j < none_components.size(); j++) {
-            Variant comp_var = none_components[j];
-            if (comp_var.get_type() == Variant::OBJECT) {
-                Ref<Resource> comp = comp_var;
-                if (comp.is_valid() && entity->has_component(comp)) {
-                    match = false;
-                    break;
-                }
-            }
-        }
-        if (!match) continue;
-        if (match) {
+
+        if (key.matches(entity->get_signature()) && _matches_values(entity)) {
             result.push_back(entity);
         }
     }
@@ -284,8 +805,11 @@ Ref<QueryBuilder> QueryBuilder::combine(const Ref<QueryBuilder> &other) {
         none_components.append_array(other->none_components);
         relationships.append_array(other->relationships);
         exclude_relationships.append_array(other->exclude_relationships);
+        reverse_relationships.append_array(other->reverse_relationships);
         groups.append_array(other->groups);
         exclude_groups.append_array(other->exclude_groups);
+        changed_components.append_array(other->changed_components);
+        added_components.append_array(other->added_components);
         invalidate_cache();
     }
     return this;
@@ -293,13 +817,17 @@ Ref<QueryBuilder> QueryBuilder::combine(const Ref<QueryBuilder> &other) {
 
 bool QueryBuilder::is_empty() const {
     return (
+        !match_nothing &&
         all_components.is_empty() &&
         any_components.is_empty() &&
         none_components.is_empty() &&
         relationships.is_empty() &&
         exclude_relationships.is_empty() &&
+        reverse_relationships.is_empty() &&
         groups.is_empty() &&
-        exclude_groups.is_empty()
+        exclude_groups.is_empty() &&
+        changed_components.is_empty() &&
+        added_components.is_empty()
     );
 }
 
@@ -316,22 +844,39 @@ Array QueryBuilder::as_array() const {
 }
 
 QueryBuilder* QueryBuilder::compile(const String &query) {
-    clear();
-    
-    PackedStringArray tokens = query.split(" ");
-    for (int i = 0; i < tokens.size(); i++) {
-        String token = tokens[i];
-        if (token == "with_all" && i + 1 < tokens.size()) {
-            String components_str = tokens[i + 1];
-        }
-        else if (token == "with_any" && i + 1 < tokens.size()) {
-            String components_str = tokens[i + 1];
-        }
-        else if (token == "with_none" && i + 1 < tokens.size()) {
-            String components_str = tokens[i + 1];
-        }
+    const QueryPlan *plan = GECS::get_query_plan(query);
+    if (plan && plan == compiled_plan) {
+        return this;
     }
-    
-    UtilityFunctions::print("Query compilation basic implementation: " + query);
+    if (plan) {
+        _apply_plan(plan);
+        compiled_plan = plan;
+        return this;
+    }
+
+    // No GECS singleton to cache in; parse for this builder only.
+    QueryPlan *local_plan = QueryPlan::parse(query);
+    if (!local_plan->valid) {
+        UtilityFunctions::push_error("Invalid query '" + query + "': " + local_plan->error);
+    }
+    _apply_plan(local_plan);
+    memdelete(local_plan);
     return this;
-}
\ No newline at end of file
+}
+
+void QueryBuilder::_apply_plan(const QueryPlan *p_plan) {
+    clear();
+    if (!p_plan->valid) {
+        match_nothing = true;
+        return;
+    }
+    // Copies, since combine() appends to these in place.
+    all_components = p_plan->all_components.duplicate();
+    any_components = p_plan->any_components.duplicate();
+    none_components = p_plan->none_components.duplicate();
+    relationships = p_plan->relationships.duplicate();
+    exclude_relationships = p_plan->exclude_relationships.duplicate();
+    groups = p_plan->groups.duplicate();
+    exclude_groups = p_plan->exclude_groups.duplicate();
+    invalidate_cache();
+}
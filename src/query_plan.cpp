@@ -0,0 +1,332 @@
+#include "query_plan.h"
+#include "component.h"
+#include "relationship.h"
+
+#include <godot_cpp/classes/project_settings.hpp>
+#include <godot_cpp/classes/resource_loader.hpp>
+#include <godot_cpp/classes/script.hpp>
+#include <godot_cpp/variant/dictionary.hpp>
+
+using namespace godot;
+
+namespace {
+
+struct QueryParser {
+    const String &text;
+    int64_t pos = 0;
+    QueryPlan *plan;
+    Dictionary global_classes;
+    bool global_classes_loaded = false;
+
+    QueryParser(const String &p_text, QueryPlan *p_plan) : text(p_text), plan(p_plan) {}
+
+    bool fail(const String &p_message) {
+        if (plan->error.is_empty()) {
+            plan->error = p_message + " at column " + String::num_int64(pos + 1);
+        }
+        return false;
+    }
+
+    void skip_space() {
+        while (pos < text.length() && (text[pos] == ' ' || text[pos] == '\t' || text[pos] == '\n' || text[pos] == '\r')) {
+            pos++;
+        }
+    }
+
+    bool peek(char32_t p_char) {
+        skip_space();
+        return pos < text.length() && text[pos] == p_char;
+    }
+
+    bool accept(char32_t p_char) {
+        if (!peek(p_char)) return false;
+        pos++;
+        return true;
+    }
+
+    bool expect(char32_t p_char) {
+        if (accept(p_char)) return true;
+        return fail(String("Expected '") + String::chr(p_char) + "'");
+    }
+
+    static bool is_name_start(char32_t c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+    }
+
+    static bool is_name_char(char32_t c) {
+        return is_name_start(c) || (c >= '0' && c <= '9');
+    }
+
+    bool parse_name(String &r_name) {
+        skip_space();
+        if (pos >= text.length() || !is_name_start(text[pos])) {
+            return fail("Expected a name");
+        }
+        int64_t start = pos;
+        while (pos < text.length() && is_name_char(text[pos])) {
+            pos++;
+        }
+        r_name = text.substr(start, pos - start);
+        return true;
+    }
+
+    bool parse_string(String &r_string) {
+        skip_space();
+        char32_t quote = text[pos];
+        int64_t start = ++pos;
+        while (pos < text.length() && text[pos] != quote) {
+            pos++;
+        }
+        if (pos >= text.length()) {
+            return fail("Unterminated string");
+        }
+        r_string = text.substr(start, pos - start);
+        pos++;
+        return true;
+    }
+
+    bool at_string() {
+        skip_space();
+        return pos < text.length() && (text[pos] == '"' || text[pos] == '\'');
+    }
+
+    bool parse_type(Ref<Resource> &r_type) {
+        String path;
+        if (at_string()) {
+            if (!parse_string(path)) return false;
+        } else {
+            String name;
+            if (!parse_name(name)) return false;
+            if (!global_classes_loaded) {
+                TypedArray<Dictionary> classes = ProjectSettings::get_singleton()->get_global_class_list();
+                for (int i = 0; i < classes.size(); i++) {
+                    Dictionary info = classes[i];
+                    global_classes[info["class"]] = info["path"];
+                }
+                global_classes_loaded = true;
+            }
+            if (!global_classes.has(name)) {
+                return fail("Unknown class '" + name + "'");
+            }
+            path = global_classes[name];
+        }
+        r_type = ResourceLoader::get_singleton()->load(path);
+        if (r_type.is_null()) {
+            return fail("Could not load '" + path + "'");
+        }
+        return true;
+    }
+
+    bool parse_value(Variant &r_value) {
+        skip_space();
+        if (pos >= text.length()) {
+            return fail("Expected a value");
+        }
+        if (at_string()) {
+            String value;
+            if (!parse_string(value)) return false;
+            r_value = value;
+            return true;
+        }
+        if (accept('[')) {
+            Array values;
+            if (!accept(']')) {
+                do {
+                    Variant value;
+                    if (!parse_value(value)) return false;
+                    values.push_back(value);
+                } while (accept(','));
+                if (!expect(']')) return false;
+            }
+            r_value = values;
+            return true;
+        }
+        if (is_name_start(text[pos])) {
+            String word;
+            parse_name(word);
+            if (word == "true" || word == "false") {
+                r_value = word == "true";
+            } else if (word == "null") {
+                r_value = Variant();
+            } else {
+                return fail("Unexpected '" + word + "'");
+            }
+            return true;
+        }
+
+        int64_t start = pos;
+        bool is_float = false;
+        if (text[pos] == '-' || text[pos] == '+') {
+            pos++;
+        }
+        while (pos < text.length()) {
+            char32_t c = text[pos];
+            if (c == '.' || c == 'e' || c == 'E') {
+                is_float = true;
+            } else if (!(c >= '0' && c <= '9') && !((c == '-' || c == '+') && (text[pos - 1] == 'e' || text[pos - 1] == 'E'))) {
+                break;
+            }
+            pos++;
+        }
+        String number = text.substr(start, pos - start);
+        if (is_float ? !number.is_valid_float() : !number.is_valid_int()) {
+            return fail("Invalid number '" + number + "'");
+        }
+        r_value = is_float ? Variant(number.to_float()) : Variant(number.to_int());
+        return true;
+    }
+
+    bool parse_operator(String &r_op) {
+        skip_space();
+        if (pos >= text.length()) {
+            return fail("Expected an operator");
+        }
+        char32_t c = text[pos];
+        char32_t next = pos + 1 < text.length() ? text[pos + 1] : 0;
+        if (c == '=' && next == '=') {
+            r_op = "_eq";
+        } else if (c == '!' && next == '=') {
+            r_op = "_ne";
+        } else if (c == '>' && next == '=') {
+            r_op = "_gte";
+        } else if (c == '<' && next == '=') {
+            r_op = "_lte";
+        } else if (c == '>' || c == '<') {
+            r_op = c == '>' ? "_gt" : "_lt";
+            pos++;
+            return true;
+        } else if (is_name_start(c)) {
+            String word;
+            parse_name(word);
+            if (word != "in" && word != "nin") {
+                return fail("Unknown operator '" + word + "'");
+            }
+            r_op = "_" + word;
+            return true;
+        } else {
+            return fail("Expected an operator");
+        }
+        pos += 2;
+        return true;
+    }
+
+    bool parse_component(Variant &r_component) {
+        Ref<Resource> type;
+        if (!parse_type(type)) return false;
+        if (!accept('{')) {
+            r_component = type;
+            return true;
+        }
+
+        Dictionary properties;
+        if (!accept('}')) {
+            do {
+                String property;
+                String op;
+                Variant value;
+                if (!parse_name(property) || !parse_operator(op) || !parse_value(value)) return false;
+                if (!properties.has(property)) {
+                    properties[property] = Dictionary();
+                }
+                Dictionary tests = properties[property];
+                tests[op] = value;
+            } while (accept(','));
+            if (!expect('}')) return false;
+        }
+        Dictionary query;
+        query[type] = properties;
+        r_component = query;
+        return true;
+    }
+
+    bool parse_relation(Variant &r_relationship) {
+        Ref<Resource> type;
+        if (!parse_type(type)) return false;
+        Ref<Script> script = type;
+        if (script.is_null()) {
+            return fail("Relationship type must be a script");
+        }
+        Ref<Component> relation = script->call("new");
+        if (relation.is_null()) {
+            return fail("Relationship type must be a Component script");
+        }
+
+        Object *target = nullptr;
+        if (accept(':') && !accept('*')) {
+            Ref<Resource> target_type;
+            if (!parse_type(target_type)) return false;
+            plan->resources.push_back(target_type);
+            target = target_type.ptr();
+        }
+
+        Ref<Relationship> relationship;
+        relationship.instantiate();
+        relationship->_init(relation, target);
+        r_relationship = relationship;
+        return true;
+    }
+
+    bool parse_query() {
+        while (true) {
+            skip_space();
+            if (pos >= text.length()) {
+                return true;
+            }
+
+            String clause;
+            if (!parse_name(clause)) return false;
+            if (!clause.begins_with("with")) {
+                clause = "with_" + clause;
+            }
+
+            Array *target = nullptr;
+            bool (QueryParser::*parse_item)(Variant &) = &QueryParser::parse_component;
+            if (clause == "with_all") {
+                target = &plan->all_components;
+            } else if (clause == "with_any") {
+                target = &plan->any_components;
+            } else if (clause == "with_none") {
+                target = &plan->none_components;
+            } else if (clause == "with_group") {
+                target = &plan->groups;
+                parse_item = &QueryParser::parse_group;
+            } else if (clause == "without_group") {
+                target = &plan->exclude_groups;
+                parse_item = &QueryParser::parse_group;
+            } else if (clause == "with_relationship") {
+                target = &plan->relationships;
+                parse_item = &QueryParser::parse_relation;
+            } else if (clause == "without_relationship") {
+                target = &plan->exclude_relationships;
+                parse_item = &QueryParser::parse_relation;
+            } else {
+                return fail("Unknown clause '" + clause + "'");
+            }
+
+            if (!expect('(')) return false;
+            if (accept(')')) continue;
+            do {
+                Variant item;
+                if (!(this->*parse_item)(item)) return false;
+                target->push_back(item);
+            } while (accept(','));
+            if (!expect(')')) return false;
+        }
+    }
+
+    bool parse_group(Variant &r_group) {
+        String group;
+        if (at_string() ? !parse_string(group) : !parse_name(group)) return false;
+        r_group = group;
+        return true;
+    }
+};
+
+}
+
+QueryPlan *QueryPlan::parse(const String &p_query) {
+    QueryPlan *plan = memnew(QueryPlan);
+    QueryParser parser(p_query, plan);
+    plan->valid = parser.parse_query();
+    return plan;
+}
@@ -6,8 +6,10 @@
 #include <godot_cpp/godot.hpp>
 #include <godot_cpp/classes/engine.hpp>
 
+#include "command_buffer.h"
 #include "component.h"
 #include "relationship.h"
+#include "prefab.h"
 #include "query_builder.h"
 #include "entity.h"
 #include "observer.h"
@@ -27,7 +29,9 @@ void initialize_gecs_module(ModuleInitializationLevel p_level) {
     // Register classes in dependency order
     ClassDB::register_class<Component>();
     ClassDB::register_class<Relationship>();
+    ClassDB::register_class<Prefab>();
     ClassDB::register_class<QueryBuilder>();
+    ClassDB::register_class<CommandBuffer>();
     ClassDB::register_class<Entity>();
     ClassDB::register_class<Observer>();
     ClassDB::register_class<System>();
@@ -7,12 +7,12 @@
 
 using namespace godot;
 
-Relationship::Relationship() : target(nullptr), source(nullptr) {}
+Relationship::Relationship() {}
 Relationship::~Relationship() {}
 
 void Relationship::_init(const Ref<Component> &p_relation, Object* p_target) {
     relation = p_relation;
-    target = p_target;
+    set_target(p_target);
 }
 
 void Relationship::_bind_methods() {
@@ -43,26 +43,25 @@ Ref<Component> Relationship::get_relation() const {
 }
 
 void Relationship::set_target(Object *p_target) {
-    target = p_target;
+    target_id = p_target ? uint64_t(p_target->get_instance_id()) : 0;
 }
 
 Object *Relationship::get_target() const {
-    return target;
+    return target_id ? ObjectDB::get_instance(target_id) : nullptr;
 }
 
 void Relationship::set_source(Object *p_source) {
-    source = p_source;
+    source_id = p_source ? uint64_t(p_source->get_instance_id()) : 0;
 }
 
 Object *Relationship::get_source() const {
-    return source;
+    return source_id ? ObjectDB::get_instance(source_id) : nullptr;
 }
 
+// ObjectIDs carry a validator, so an ID whose object was freed (even if its
+// slot was reused) no longer resolves.
 bool Relationship::is_valid() const {
-    // NOTE: Compromise to ensure compilation.
-    // Proper check requires ObjectDB, which is failing to include.
-    // This may lead to crashes if an entity in a relationship is freed.
-    return source != nullptr;
+    return get_source() != nullptr && (target_id == 0 || get_target() != nullptr);
 }
 
 bool Relationship::matches(const Ref<Relationship> &other, bool weak) const {
@@ -73,18 +72,21 @@ bool Relationship::matches(const Ref<Relationship> &other, bool weak) const {
         rel_match = true;
     } else {
         if (weak) {
-            Ref<Script> rel_script = relation->get_script();
-            Ref<Script> other_rel_script = other->get_relation()->get_script();
-            if(rel_script.is_valid() && other_rel_script.is_valid()) {
-                rel_match = rel_script->get_path() == other_rel_script->get_path();
-            }
+            int rel_type = relation->get_type_id();
+            rel_match = rel_type >= 0 && rel_type == other->get_relation()->get_type_id();
         } else {
             rel_match = relation->equals(other->get_relation());
         }
     }
 
+    // A target that was set but has since been freed matches nothing, not everything.
+    Object *target = get_target();
+    Object *other_target = other->get_target();
+    if ((target_id && !target) || (other->target_id && !other_target)) {
+        return false;
+    }
+
     bool target_match = false;
-    Object* other_target = other->get_target();
     if (other_target == nullptr || target == nullptr) {
         target_match = true;
     } else {
@@ -0,0 +1,175 @@
+#include "relationship_index.h"
+#include "component.h"
+#include "entity.h"
+
+#include <godot_cpp/classes/script.hpp>
+
+using namespace godot;
+
+int RelationshipIndex::relation_type(const Ref<Relationship> &p_relationship) {
+    Ref<Component> relation = p_relationship->get_relation();
+    return relation.is_valid() ? relation->get_type_id() : -1;
+}
+
+uint64_t RelationshipIndex::target_key(const Ref<Relationship> &p_relationship) {
+    Object *target = p_relationship->get_target();
+    if (!target || Object::cast_to<Script>(target)) {
+        return 0;
+    }
+    return target->get_instance_id();
+}
+
+template <typename K>
+void RelationshipIndex::_increment(HashMap<K, uint32_t> &r_set, const K &p_key) {
+    uint32_t *count = r_set.getptr(p_key);
+    if (count) {
+        (*count)++;
+    } else {
+        r_set.insert(p_key, 1);
+    }
+}
+
+template <typename K>
+bool RelationshipIndex::_decrement(HashMap<K, uint32_t> &r_set, const K &p_key) {
+    uint32_t *count = r_set.getptr(p_key);
+    if (!count) {
+        return false;
+    }
+    if (--(*count) == 0) {
+        r_set.erase(p_key);
+    }
+    return true;
+}
+
+void RelationshipIndex::_add_target(Targets &r_targets, const Filed &p_filed) {
+    _increment(p_filed.script_target ? r_targets.scripts : r_targets.entities, p_filed.target);
+}
+
+void RelationshipIndex::_remove_target(Targets &r_targets, const Filed &p_filed) {
+    _decrement(p_filed.script_target ? r_targets.scripts : r_targets.entities, p_filed.target);
+}
+
+void RelationshipIndex::add(Entity *p_source, const Ref<Relationship> &p_relationship) {
+    const FiledKey filed_key(p_relationship.ptr(), p_source->get_instance_id());
+    Filed *entry = filed.getptr(filed_key);
+    if (entry) {
+        entry->count++;
+    } else {
+        Filed new_entry;
+        new_entry.key = TargetKey(relation_type(p_relationship), target_key(p_relationship));
+        Object *target = p_relationship->get_target();
+        if (target) {
+            new_entry.target = target->get_instance_id();
+            new_entry.script_target = Object::cast_to<Script>(target) != nullptr;
+        }
+        new_entry.count = 1;
+        entry = &filed.insert(filed_key, new_entry)->value;
+    }
+    const TargetKey key = entry->key;
+    if (entry->target) {
+        _add_target(targets_by_type[key.type_id], *entry);
+        _add_target(all_targets, *entry);
+        if (!entry->script_target) {
+            Reference reference;
+            reference.source = filed_key.source;
+            reference.relationship = p_relationship.ptr();
+            referencing[entry->target].push_back(reference);
+        }
+    }
+
+    if (key.type_id < 0) {
+        _increment(untyped, p_source);
+        return;
+    }
+    if (uint32_t(key.type_id) >= by_type.size()) {
+        by_type.resize(key.type_id + 1);
+    }
+    _increment(by_type[key.type_id], p_source);
+
+    SourceSet *sources = by_target.getptr(key);
+    if (!sources) {
+        sources = &by_target.insert(key, SourceSet())->value;
+    }
+    _increment(*sources, p_source);
+}
+
+void RelationshipIndex::remove(Entity *p_source, const Ref<Relationship> &p_relationship) {
+    const FiledKey filed_key(p_relationship.ptr(), p_source->get_instance_id());
+    Filed *entry = filed.getptr(filed_key);
+    if (!entry) {
+        return;
+    }
+    const Filed removed = *entry;
+    const TargetKey key = removed.key;
+    if (--entry->count == 0) {
+        filed.erase(filed_key);
+    }
+    if (removed.target) {
+        Targets *targets = targets_by_type.getptr(key.type_id);
+        if (targets) {
+            _remove_target(*targets, removed);
+        }
+        _remove_target(all_targets, removed);
+        LocalVector<Reference> *pointing = removed.script_target ? nullptr : referencing.getptr(removed.target);
+        if (pointing) {
+            for (uint32_t i = 0; i < pointing->size(); i++) {
+                if ((*pointing)[i].source == filed_key.source && (*pointing)[i].relationship == filed_key.relationship) {
+                    pointing->remove_at_unordered(i);
+                    break;
+                }
+            }
+            if (pointing->is_empty()) {
+                referencing.erase(removed.target);
+            }
+        }
+    }
+
+    if (key.type_id < 0) {
+        _decrement(untyped, p_source);
+        return;
+    }
+    _decrement(by_type[key.type_id], p_source);
+    SourceSet *sources = by_target.getptr(key);
+    if (sources && _decrement(*sources, p_source) && sources->is_empty()) {
+        by_target.erase(key);
+    }
+}
+
+void RelationshipIndex::clear() {
+    by_type.clear();
+    by_target.clear();
+    untyped.clear();
+    targets_by_type.clear();
+    all_targets = Targets();
+    referencing.clear();
+    filed.clear();
+}
+
+const RelationshipIndex::SourceSet *RelationshipIndex::get_sources(int p_type_id, uint64_t p_target) const {
+    if (p_target == 0) {
+        return uint32_t(p_type_id) < by_type.size() ? &by_type[p_type_id] : nullptr;
+    }
+    return by_target.getptr(TargetKey(p_type_id, p_target));
+}
+
+const RelationshipIndex::Targets *RelationshipIndex::get_targets(int p_type_id) const {
+    return p_type_id < 0 ? &all_targets : targets_by_type.getptr(p_type_id);
+}
+
+const RelationshipIndex::Targets *RelationshipIndex::get_untyped_targets() const {
+    return targets_by_type.getptr(-1);
+}
+
+const LocalVector<RelationshipIndex::Reference> *RelationshipIndex::get_referencing(uint64_t p_target) const {
+    return referencing.getptr(p_target);
+}
+
+bool RelationshipIndex::is_target(int p_type_id, uint64_t p_entity, uint64_t p_script) const {
+    const Targets *targets = get_targets(p_type_id);
+    if (targets && (targets->entities.has(p_entity) || (p_script && targets->scripts.has(p_script)))) {
+        return true;
+    }
+    // A null relation matches every relation type.
+    const Targets *untyped_targets = p_type_id >= 0 ? get_untyped_targets() : nullptr;
+    return untyped_targets && (untyped_targets->entities.has(p_entity) || (p_script && untyped_targets->scripts.has(p_script)));
+}
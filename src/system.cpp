@@ -2,14 +2,24 @@
 #include "gecs.h"
 #include "world.h"
 #include "entity.h"
+#include "component.h"
 #include "query_builder.h"
+#include "system_scheduler.h"
 #include <godot_cpp/core/class_db.hpp>
 #include <godot_cpp/classes/script.hpp>
+#include <godot_cpp/classes/worker_thread_pool.hpp>
+#include <godot_cpp/variant/packed_float32_array.hpp>
+#include <godot_cpp/variant/packed_int64_array.hpp>
+#include <godot_cpp/variant/packed_string_array.hpp>
+#include <godot_cpp/variant/packed_vector2_array.hpp>
+#include <godot_cpp/variant/packed_vector3_array.hpp>
 #include <godot_cpp/variant/utility_functions.hpp>
 
 using namespace godot;
 
-System::System() {}
+System::System() {
+    cmd.instantiate();
+}
 
 System::~System() {}
 
@@ -41,10 +51,48 @@ void System::_bind_methods() {
     ClassDB::bind_method(D_METHOD("set_paused", "p_value"), &System::set_paused);
     ADD_PROPERTY(PropertyInfo(Variant::BOOL, "paused"), "set_paused", "get_paused");
 
+    ClassDB::bind_method(D_METHOD("is_thread_safe"), &System::is_thread_safe);
+    ClassDB::bind_method(D_METHOD("set_thread_safe", "p_value"), &System::set_thread_safe);
+    ADD_PROPERTY(PropertyInfo(Variant::BOOL, "thread_safe"), "set_thread_safe", "is_thread_safe");
+
+    ClassDB::bind_method(D_METHOD("get_reads"), &System::get_reads);
+    ClassDB::bind_method(D_METHOD("set_reads", "p_value"), &System::set_reads);
+    ADD_PROPERTY(PropertyInfo(Variant::ARRAY, "reads"), "set_reads", "get_reads");
+
+    ClassDB::bind_method(D_METHOD("get_writes"), &System::get_writes);
+    ClassDB::bind_method(D_METHOD("set_writes", "p_value"), &System::set_writes);
+    ADD_PROPERTY(PropertyInfo(Variant::ARRAY, "writes"), "set_writes", "get_writes");
+
+    ClassDB::bind_method(D_METHOD("is_parallel"), &System::is_parallel);
+    ClassDB::bind_method(D_METHOD("set_parallel", "p_value"), &System::set_parallel);
+    ADD_PROPERTY(PropertyInfo(Variant::BOOL, "parallel"), "set_parallel", "is_parallel");
+
+    ClassDB::bind_method(D_METHOD("get_grain_size"), &System::get_grain_size);
+    ClassDB::bind_method(D_METHOD("set_grain_size", "p_value"), &System::set_grain_size);
+    ADD_PROPERTY(PropertyInfo(Variant::INT, "grain_size", PROPERTY_HINT_RANGE, "1,4096,1,or_greater"), "set_grain_size", "get_grain_size");
+
+    ClassDB::bind_method(D_METHOD("is_deterministic"), &System::is_deterministic);
+    ClassDB::bind_method(D_METHOD("set_deterministic", "p_value"), &System::set_deterministic);
+    ADD_PROPERTY(PropertyInfo(Variant::BOOL, "deterministic"), "set_deterministic", "is_deterministic");
+
+    GDVIRTUAL_BIND(deps);
+    GDVIRTUAL_BIND(query);
+    GDVIRTUAL_BIND(sub_systems);
+    GDVIRTUAL_BIND(setup);
+    GDVIRTUAL_BIND(process, "entity", "delta");
+    GDVIRTUAL_BIND(process_all, "entities", "delta");
+    GDVIRTUAL_BIND(process_batch, "entities", "columns", "delta");
+
+    ClassDB::bind_method(D_METHOD("get_batch_columns"), &System::get_batch_columns);
+    ClassDB::bind_method(D_METHOD("set_batch_columns", "p_value"), &System::set_batch_columns);
+    ADD_PROPERTY(PropertyInfo(Variant::DICTIONARY, "batch_columns"), "set_batch_columns", "get_batch_columns");
+
     ClassDB::bind_method(D_METHOD("_handle", "delta"), &System::_handle);
     ClassDB::bind_method(D_METHOD("set_q", "query_builder"), &System::set_q);
     ClassDB::bind_method(D_METHOD("get_q"), &System::get_q);
     ADD_PROPERTY(PropertyInfo(Variant::OBJECT, "q", PROPERTY_HINT_RESOURCE_TYPE, "QueryBuilder", PROPERTY_USAGE_NO_EDITOR), "", "get_q");
+    ClassDB::bind_method(D_METHOD("get_cmd"), &System::get_cmd);
+    ADD_PROPERTY(PropertyInfo(Variant::OBJECT, "cmd", PROPERTY_HINT_RESOURCE_TYPE, "CommandBuffer", PROPERTY_USAGE_NO_EDITOR), "", "get_cmd");
 }
 
 void System::set_q(const Ref<QueryBuilder> &p_q) {
@@ -53,82 +101,462 @@ void System::set_q(const Ref<QueryBuilder> &p_q) {
 
 Ref<QueryBuilder> System::get_q() {
     if (q.is_null()) {
-        GECS* ecs = GECS::get_singleton();
-        if (ecs && ecs->get_world()) {
-            set_q(ecs->get_world()->get_query());
+        World *world = _get_world();
+        if (world) {
+            set_q(world->get_query());
         }
     }
     return q;
 }
 
+Ref<CommandBuffer> System::get_cmd() const {
+    return cmd;
+}
+
+void System::_set_world(World *p_world) {
+    world_id = p_world ? p_world->get_instance_id() : 0;
+    cmd->_set_world(p_world);
+}
+
+World *System::_get_world() const {
+    World *world = world_id ? Object::cast_to<World>(ObjectDB::get_instance(world_id)) : nullptr;
+    if (!world && GECS::get_singleton()) {
+        world = GECS::get_singleton()->get_world();
+    }
+    return world;
+}
+
 void System::_handle(double delta) {
+    if (_declare_access()) {
+        _prepare_entities(delta);
+        _run();
+    }
+}
+
+bool System::_declare_access() {
     if (!active || paused) {
-        return;
+        return false;
     }
 
-    if (has_method("sub_systems") && !sub_systems().is_empty()) {
-        return;
+    if (!sub_systems_resolved) {
+        _resolve_sub_systems();
     }
-    
-    Ref<QueryBuilder> qb = query();
-    if (qb.is_valid()) {
-        Array entities = qb->execute();
-        process_all(entities, delta);
+
+    // Everything the queries filter on is read; reads/writes add what process() touches beyond it.
+    read_mask.clear();
+    if (!sub_system_list.is_empty()) {
+        for (uint32_t i = 0; i < sub_system_list.size(); i++) {
+            const World::QueryCacheKey &key = sub_system_list[i].query->_get_query_key();
+            read_mask.merge(key.all);
+            read_mask.merge(key.any);
+        }
+    } else {
+        pending_query = query();
+        if (pending_query.is_null()) {
+            return false;
+        }
+        const World::QueryCacheKey &key = pending_query->_get_query_key();
+        read_mask.merge(key.all);
+        read_mask.merge(key.any);
+    }
+    for (int i = 0; i < reads.size(); i++) {
+        read_mask.set(GECS::get_component_type_id_for_object(reads[i]));
+    }
+    write_mask.clear();
+    for (int i = 0; i < writes.size(); i++) {
+        write_mask.set(GECS::get_component_type_id_for_object(writes[i]));
+    }
+    if (batch_columns_dirty) {
+        _compile_batch_columns();
+    }
+    return true;
+}
+
+bool System::_conflicts_with(const System *p_other) const {
+    if (!thread_safe || !p_other->thread_safe) {
+        return true;
+    }
+    return write_mask.intersects(p_other->write_mask) || write_mask.intersects(p_other->read_mask) || read_mask.intersects(p_other->write_mask);
+}
+
+void System::_prepare_entities(double delta) {
+    // Taken here, on the main thread in wave order, so ticks follow the schedule.
+    World *world = _get_world();
+    run_tick = world ? world->_next_change_tick() : 0;
+    if (pending_query.is_valid()) {
+        pending_query->_set_change_since(last_run_tick);
+        pending_entities = pending_query->execute();
+    }
+    // Worker threads must not execute queries; the sub-system ones run here too.
+    pending_sub_entities.resize(sub_system_list.size());
+    for (uint32_t i = 0; i < sub_system_list.size(); i++) {
+        sub_system_list[i].query->_set_change_since(last_run_tick);
+        pending_sub_entities[i] = sub_system_list[i].query->execute();
+    }
+    pending_delta = delta;
+}
+
+void System::_run() {
+    uint64_t previous_tick = World::system_tick;
+    World::system_tick = run_tick;
+    if (!sub_system_list.is_empty()) {
+        _run_sub_systems();
+    } else {
+        process_all(pending_entities, pending_delta);
+        pending_entities = Array();
+        pending_query.unref();
+    }
+    World::system_tick = previous_tick;
+    last_run_tick = run_tick;
+}
+
+void System::_resolve_sub_systems() {
+    sub_system_list.clear();
+    sub_systems_resolved = true;
+
+    Array pairs = sub_systems();
+    for (int i = 0; i < pairs.size(); i++) {
+        Array pair = pairs[i];
+        SubSystem sub;
+        if (pair.size() >= 2) {
+            sub.query = pair[0];
+            sub.callable = pair[1];
+        }
+        if (sub.query.is_null() || !sub.callable.is_valid()) {
+            UtilityFunctions::push_error("sub_systems()[" + String::num_int64(i) + "] must be [QueryBuilder, Callable].");
+            continue;
+        }
+        bool shared = false;
+        for (uint32_t j = 0; j < sub_system_list.size() && !shared; j++) {
+            shared = sub_system_list[j].query == sub.query;
+        }
+        if (shared) {
+            // The same builder twice means the later with_*() calls rewrote the earlier query.
+            UtilityFunctions::push_error("sub_systems()[" + String::num_int64(i) + "] reuses a QueryBuilder; build each one from world.get_query().");
+            continue;
+        }
+        sub_system_list.push_back(sub);
     }
 }
 
+void System::_run_sub_systems() {
+    // In declaration order. On the main thread each later query runs again so it
+    // sees what the previous callables changed; workers defer those changes, so
+    // the results staged in _prepare_entities() are still current there.
+    bool worker = SystemScheduler::is_worker_thread();
+    for (uint32_t i = 0; i < sub_system_list.size(); i++) {
+        const SubSystem &sub = sub_system_list[i];
+        Array entities = pending_sub_entities[i];
+        if (i > 0 && !worker) {
+            entities = sub.query->execute();
+        }
+        for (int j = 0; j < entities.size(); j++) {
+            sub.callable.call(entities[j], pending_delta);
+        }
+    }
+    pending_sub_entities.clear();
+}
+
+void System::_run_task() {
+    SystemScheduler::worker_thread = true;
+    SystemScheduler::deferred_calls = &deferred_calls;
+    _run();
+    SystemScheduler::deferred_calls = nullptr;
+    SystemScheduler::worker_thread = false;
+}
+
+void System::_sync() {
+    for (uint32_t i = 0; i < deferred_calls.size(); i++) {
+        deferred_calls[i].call();
+    }
+    deferred_calls.clear();
+    cmd->flush();
+}
+
+void System::_resolve_script_overrides() {
+    script_overrides = OVERRIDES_RESOLVED;
+    if (GDVIRTUAL_IS_OVERRIDDEN(deps)) script_overrides |= OVERRIDE_DEPS;
+    if (GDVIRTUAL_IS_OVERRIDDEN(query)) script_overrides |= OVERRIDE_QUERY;
+    if (GDVIRTUAL_IS_OVERRIDDEN(sub_systems)) script_overrides |= OVERRIDE_SUB_SYSTEMS;
+    if (GDVIRTUAL_IS_OVERRIDDEN(setup)) script_overrides |= OVERRIDE_SETUP;
+    if (GDVIRTUAL_IS_OVERRIDDEN(process)) script_overrides |= OVERRIDE_PROCESS;
+    if (GDVIRTUAL_IS_OVERRIDDEN(process_all)) script_overrides |= OVERRIDE_PROCESS_ALL;
+    if (GDVIRTUAL_IS_OVERRIDDEN(process_batch)) script_overrides |= OVERRIDE_PROCESS_BATCH;
+}
+
 Dictionary System::deps() {
-    if (has_method("deps")) {
-        return call("deps");
+    Dictionary ret;
+    if (_is_overridden(OVERRIDE_DEPS) && GDVIRTUAL_CALL(deps, ret)) {
+        return ret;
     }
     return Dictionary();
 }
 
 Ref<QueryBuilder> System::query() {
-    if (has_method("query")) {
-        return call("query");
+    Ref<QueryBuilder> ret;
+    if (_is_overridden(OVERRIDE_QUERY) && GDVIRTUAL_CALL(query, ret)) {
+        return ret;
     }
     process_empty = true;
     return get_q();
 }
 
 Array System::sub_systems() {
-    if (has_method("sub_systems")) {
-        return call("sub_systems");
+    Array ret;
+    if (_is_overridden(OVERRIDE_SUB_SYSTEMS) && GDVIRTUAL_CALL(sub_systems, ret)) {
+        return ret;
     }
     return Array();
 }
 
 void System::setup() {
-    if (has_method("setup")) {
-        call("setup");
+    // The script is in place by the time the world sets the system up; look its overrides up afresh.
+    _resolve_script_overrides();
+    if (_is_overridden(OVERRIDE_SETUP)) {
+        GDVIRTUAL_CALL(setup);
     }
+    _resolve_sub_systems();
 }
 
 void System::process(Entity *entity, double delta) {
-    if (has_method("process")) {
-        call("process", entity, delta);
+    if (_is_overridden(OVERRIDE_PROCESS)) {
+        GDVIRTUAL_CALL(process, entity, delta);
     }
 }
 
 bool System::process_all(const Array &entities, double delta) {
-    if (has_method("process_all")) {
-        return call("process_all", entities, delta);
+    bool ret = false;
+    if (_is_overridden(OVERRIDE_PROCESS_ALL) && GDVIRTUAL_CALL(process_all, entities, delta, ret)) {
+        return ret;
     }
 
     if (entities.is_empty() && process_empty) {
         process(nullptr, delta);
         return true;
     }
-    
-    for (int i = 0; i < entities.size(); i++) {
-        Entity* entity = Object::cast_to<Entity>(entities[i]);
+
+    if (parallel && thread_safe && entities.size() > grain_size) {
+        _process_parallel(entities, delta);
+        return true;
+    }
+
+    for (int64_t begin = 0; begin < entities.size(); begin += grain_size) {
+        _process_range(entities, begin, MIN(begin + grain_size, entities.size()), delta);
+    }
+    return !entities.is_empty();
+}
+
+void System::_process_range(const Array &entities, int64_t begin, int64_t end, double delta) {
+    if (_is_overridden(OVERRIDE_PROCESS_BATCH)) {
+        _process_batch(entities.slice(begin, end), delta);
+        for (int64_t i = begin; i < end; i++) {
+            Entity *entity = Object::cast_to<Entity>(entities[i]);
+            if (entity) {
+                entity->on_update(delta);
+            }
+        }
+        return;
+    }
+
+    for (int64_t i = begin; i < end; i++) {
+        Entity *entity = Object::cast_to<Entity>(entities[i]);
         if (entity) {
             process(entity, delta);
             entity->on_update(delta);
         }
     }
-    return !entities.is_empty();
+}
+
+namespace {
+
+template <typename P, typename T>
+Variant _pack_column(const LocalVector<Variant> &p_values) {
+    P packed;
+    packed.resize(p_values.size());
+    T *w = packed.ptrw();
+    for (uint32_t i = 0; i < p_values.size(); i++) {
+        w[i] = p_values[i];
+    }
+    return packed;
+}
+
+template <typename P>
+void _write_back_column(const Variant &p_old, const Variant &p_new, const LocalVector<Component *> &p_owners, const StringName &p_property) {
+    P old_values = p_old;
+    P new_values = p_new;
+    if (new_values.size() != old_values.size()) {
+        UtilityFunctions::push_error("process_batch() must not resize column '" + String(p_property) + "'.");
+        return;
+    }
+    for (uint32_t i = 0; i < p_owners.size(); i++) {
+        if (p_owners[i] && !(new_values[i] == old_values[i])) {
+            p_owners[i]->set(p_property, new_values[i]);
+        }
+    }
+}
+
+}
+
+void System::_process_batch(const Array &entities, double delta) {
+    Dictionary columns;
+    LocalVector<Variant> originals;
+    LocalVector<LocalVector<Component *>> owners;
+    originals.resize(batch_column_specs.size());
+    owners.resize(batch_column_specs.size());
+
+    LocalVector<Variant> values;
+    values.resize(entities.size());
+    for (uint32_t c = 0; c < batch_column_specs.size(); c++) {
+        const BatchColumn &column = batch_column_specs[c];
+        owners[c].resize(entities.size());
+        Variant::Type type = Variant::NIL;
+        bool uniform = true;
+        for (int64_t i = 0; i < entities.size(); i++) {
+            Entity *entity = Object::cast_to<Entity>(entities[i]);
+            Component *component = entity ? entity->get_component_by_type_id(column.type_id).ptr() : nullptr;
+            owners[c][i] = component;
+            values[i] = component ? component->get(column.property) : Variant();
+            if (i == 0) {
+                type = values[i].get_type();
+            }
+            uniform = uniform && values[i].get_type() == type;
+        }
+
+        // Uniform columns of common types are packed; anything else stays an Array.
+        Variant packed;
+        switch (uniform ? type : Variant::NIL) {
+            case Variant::INT: packed = _pack_column<PackedInt64Array, int64_t>(values); break;
+            case Variant::FLOAT: packed = _pack_column<PackedFloat32Array, float>(values); break;
+            case Variant::STRING: packed = _pack_column<PackedStringArray, String>(values); break;
+            case Variant::VECTOR2: packed = _pack_column<PackedVector2Array, Vector2>(values); break;
+            case Variant::VECTOR3: packed = _pack_column<PackedVector3Array, Vector3>(values); break;
+            default: {
+                Array array;
+                array.resize(values.size());
+                for (uint32_t i = 0; i < values.size(); i++) {
+                    array[i] = values[i];
+                }
+                packed = array;
+            } break;
+        }
+        originals[c] = packed;
+        columns[column.name] = packed;
+    }
+
+    GDVIRTUAL_CALL(process_batch, entities, columns, delta);
+
+    // Only columns of components the system declares in writes go back to the components.
+    for (uint32_t c = 0; c < batch_column_specs.size(); c++) {
+        const BatchColumn &column = batch_column_specs[c];
+        if (!write_mask.has(column.type_id)) continue;
+        Variant updated = columns.get(column.name, Variant());
+        if (updated.get_type() != originals[c].get_type()) {
+            UtilityFunctions::push_error("process_batch() must not change the type of column '" + String(column.name) + "'.");
+            continue;
+        }
+        switch (updated.get_type()) {
+            case Variant::PACKED_INT64_ARRAY: _write_back_column<PackedInt64Array>(originals[c], updated, owners[c], column.property); break;
+            case Variant::PACKED_FLOAT32_ARRAY: _write_back_column<PackedFloat32Array>(originals[c], updated, owners[c], column.property); break;
+            case Variant::PACKED_STRING_ARRAY: _write_back_column<PackedStringArray>(originals[c], updated, owners[c], column.property); break;
+            case Variant::PACKED_VECTOR2_ARRAY: _write_back_column<PackedVector2Array>(originals[c], updated, owners[c], column.property); break;
+            case Variant::PACKED_VECTOR3_ARRAY: _write_back_column<PackedVector3Array>(originals[c], updated, owners[c], column.property); break;
+            default: _write_back_column<Array>(originals[c], updated, owners[c], column.property); break;
+        }
+    }
+}
+
+void System::_compile_batch_columns() {
+    batch_column_specs.clear();
+    batch_columns_dirty = false;
+    Array names = batch_columns.keys();
+    for (int i = 0; i < names.size(); i++) {
+        Array spec = batch_columns[names[i]];
+        BatchColumn column;
+        column.name = names[i];
+        if (spec.size() == 2) {
+            column.type_id = GECS::get_component_type_id_for_object(spec[0]);
+            column.property = spec[1];
+        }
+        if (column.type_id < 0 || column.property.is_empty()) {
+            UtilityFunctions::push_error("batch_columns['" + String(column.name) + "'] must be [ComponentScript, \"property\"].");
+            continue;
+        }
+        batch_column_specs.push_back(column);
+    }
+}
+
+void System::_process_parallel(const Array &entities, double delta) {
+    uint32_t chunk_count = (entities.size() + grain_size - 1) / grain_size;
+    chunk_entities = entities;
+    chunk_delta = delta;
+    chunk_calls.resize(chunk_count);
+    chunk_order.clear();
+    cmd->_begin_lanes(chunk_count);
+
+    if (SystemScheduler::is_worker_thread()) {
+        // Already a wave task: waiting on a nested group task could starve the
+        // pool, so the chunks run here, one after another.
+        for (uint32_t c = 0; c < chunk_count; c++) {
+            _process_chunk(c);
+        }
+    } else {
+        WorkerThreadPool *pool = WorkerThreadPool::get_singleton();
+        int64_t group_task = pool->add_group_task(callable_mp(this, &System::_process_chunk), chunk_count, -1, true, "GECS system chunks");
+        pool->wait_for_group_task_completion(group_task);
+    }
+    chunk_entities = Array();
+    cmd->_merge_lanes();
+
+    // Deterministic systems replay in chunk order, whichever thread ran each chunk;
+    // the others in the order their chunks finished.
+    if (deterministic) {
+        chunk_order.resize(chunk_count);
+        for (uint32_t c = 0; c < chunk_count; c++) {
+            chunk_order[c] = c;
+        }
+    }
+    for (uint32_t o = 0; o < chunk_order.size(); o++) {
+        const LocalVector<Callable> &calls = chunk_calls[chunk_order[o]];
+        for (uint32_t i = 0; i < calls.size(); i++) {
+            if (SystemScheduler::is_worker_thread()) {
+                SystemScheduler::defer_call(calls[i]);
+            } else {
+                calls[i].call();
+            }
+        }
+    }
+    chunk_calls.clear();
+    chunk_order.clear();
+}
+
+void System::_process_chunk(uint32_t p_chunk) {
+    int64_t begin = int64_t(p_chunk) * grain_size;
+    int64_t end = MIN(begin + grain_size, chunk_entities.size());
+
+    bool was_worker = SystemScheduler::worker_thread;
+    LocalVector<Callable> *previous_calls = SystemScheduler::deferred_calls;
+    CommandBuffer *previous_lane_buffer = CommandBuffer::lane_buffer;
+    uint32_t previous_lane = CommandBuffer::lane_index;
+    uint64_t previous_tick = World::system_tick;
+    SystemScheduler::worker_thread = true;
+    SystemScheduler::deferred_calls = &chunk_calls[p_chunk];
+    CommandBuffer::lane_buffer = cmd.ptr();
+    CommandBuffer::lane_index = p_chunk;
+    World::system_tick = run_tick;
+
+    _process_range(chunk_entities, begin, end, chunk_delta);
+
+    if (!deterministic) {
+        cmd->_merge_lane(p_chunk);
+        std::lock_guard<std::mutex> lock(chunk_mutex);
+        chunk_order.push_back(p_chunk);
+    }
+
+    SystemScheduler::worker_thread = was_worker;
+    SystemScheduler::deferred_calls = previous_calls;
+    CommandBuffer::lane_buffer = previous_lane_buffer;
+    CommandBuffer::lane_index = previous_lane;
+    World::system_tick = previous_tick;
 }
 
 void System::set_group(const String &p_group) { 
@@ -169,4 +597,61 @@ void System::set_paused(bool p_paused) {
 
 bool System::get_paused() const { 
     return paused;
+}
+
+void System::set_thread_safe(bool p_thread_safe) {
+    thread_safe = p_thread_safe;
+}
+
+bool System::is_thread_safe() const {
+    return thread_safe;
+}
+
+void System::set_reads(const Array &p_reads) {
+    reads = p_reads;
+}
+
+Array System::get_reads() const {
+    return reads;
+}
+
+void System::set_writes(const Array &p_writes) {
+    writes = p_writes;
+}
+
+Array System::get_writes() const {
+    return writes;
+}
+
+void System::set_parallel(bool p_parallel) {
+    parallel = p_parallel;
+}
+
+bool System::is_parallel() const {
+    return parallel;
+}
+
+void System::set_grain_size(int p_grain_size) {
+    grain_size = MAX(p_grain_size, 1);
+}
+
+int System::get_grain_size() const {
+    return grain_size;
+}
+
+void System::set_deterministic(bool p_deterministic) {
+    deterministic = p_deterministic;
+}
+
+bool System::is_deterministic() const {
+    return deterministic;
+}
+
+void System::set_batch_columns(const Dictionary &p_columns) {
+    batch_columns = p_columns;
+    batch_columns_dirty = true;
+}
+
+Dictionary System::get_batch_columns() const {
+    return batch_columns;
 }
\ No newline at end of file
@@ -0,0 +1,110 @@
+#include "system_scheduler.h"
+#include "command_buffer.h"
+#include "system.h"
+
+#include <godot_cpp/classes/worker_thread_pool.hpp>
+
+using namespace godot;
+
+thread_local bool SystemScheduler::worker_thread = false;
+thread_local LocalVector<Callable> *SystemScheduler::deferred_calls = nullptr;
+
+bool SystemScheduler::is_worker_thread() {
+    return worker_thread;
+}
+
+void SystemScheduler::defer_call(const Callable &p_call) {
+    if (deferred_calls) {
+        deferred_calls->push_back(p_call);
+    } else {
+        p_call.call_deferred();
+    }
+}
+
+bool SystemScheduler::_depends_on(const Dictionary &p_deps, System *p_other) {
+    Variant other = p_other;
+    Variant other_script = p_other->get_script();
+    for (int r = System::Before; r <= System::After; r++) {
+        if (!p_deps.has(r)) continue;
+        Array entries = p_deps[r];
+        for (int i = 0; i < entries.size(); i++) {
+            // A null entry orders against every system in the group.
+            if (entries[i].get_type() == Variant::NIL || entries[i] == other || entries[i] == other_script) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void SystemScheduler::run(const Array &p_systems, double p_delta, bool p_multithreaded) {
+    if (!p_multithreaded) {
+        for (int i = 0; i < p_systems.size(); i++) {
+            System *system = Object::cast_to<System>(p_systems[i]);
+            if (system) {
+                system->_handle(p_delta);
+                system->get_cmd()->flush();
+            }
+        }
+        return;
+    }
+
+    systems.clear();
+    system_deps.clear();
+    for (int i = 0; i < p_systems.size(); i++) {
+        System *system = Object::cast_to<System>(p_systems[i]);
+        if (system && system->_declare_access()) {
+            systems.push_back(system);
+            system_deps.push_back(system->deps());
+        }
+    }
+
+    waves.resize(systems.size());
+    uint32_t wave_count = 0;
+    for (uint32_t j = 0; j < systems.size(); j++) {
+        uint32_t wave = 0;
+        for (uint32_t i = 0; i < j; i++) {
+            if (waves[i] >= wave && (systems[i]->_conflicts_with(systems[j]) || _depends_on(system_deps[i], systems[j]) || _depends_on(system_deps[j], systems[i]))) {
+                wave = waves[i] + 1;
+            }
+        }
+        waves[j] = wave;
+        wave_count = MAX(wave_count, wave + 1);
+    }
+
+    WorkerThreadPool *pool = WorkerThreadPool::get_singleton();
+    for (uint32_t wave = 0; wave < wave_count; wave++) {
+        tasks.clear();
+        System *single = nullptr;
+        uint32_t size = 0;
+        for (uint32_t i = 0; i < systems.size(); i++) {
+            if (waves[i] == wave) {
+                systems[i]->_prepare_entities(p_delta);
+                single = systems[i];
+                size++;
+            }
+        }
+        if (size == 1) {
+            single->_run();
+            single->get_cmd()->flush();
+            continue;
+        }
+        for (uint32_t i = 0; i < systems.size(); i++) {
+            if (waves[i] == wave) {
+                tasks.push_back(pool->add_task(callable_mp(systems[i], &System::_run_task), true, "GECS system"));
+            }
+        }
+        for (uint32_t i = 0; i < tasks.size(); i++) {
+            pool->wait_for_task_completion(tasks[i]);
+        }
+        // Sync point: the wave's deferred calls and recorded changes land, in
+        // system order, before the next wave queries.
+        for (uint32_t i = 0; i < systems.size(); i++) {
+            if (waves[i] == wave) {
+                systems[i]->_sync();
+            }
+        }
+    }
+    systems.clear();
+    system_deps.clear();
+}
@@ -6,6 +6,10 @@
 #include "component.h"
 #include "relationship.h"
 #include "gecs.h"
+#include "archetype.h"
+#include "component_mask.h"
+#include "property_index.h"
+#include "prefab.h"
 
 #include <godot_cpp/core/class_db.hpp>
 #include <godot_cpp/variant/utility_functions.hpp>
@@ -13,15 +17,45 @@
 
 using namespace godot;
 
+thread_local uint64_t World::system_tick = 0;
+
+struct World::CachedQuery {
+    QueryCacheKey key;
+    Array result;
+    HashMap<Entity *, int64_t> positions;
+    bool shared = false;
+    uint64_t version = 0;
+};
+
+static const char *invalidation_names[World::INVALIDATION_MAX] = {
+    "entity_added",
+    "entity_removed",
+    "component_added",
+    "component_removed",
+    "property_changed",
+};
+
 World::World() {}
 
-World::~World() {}
+World::~World() {
+    _clear_storage();
+}
 
 void World::_bind_methods() {
-    ClassDB::bind_method(D_METHOD("add_entity", "entity"), &World::add_entity);
+    ClassDB::bind_method(D_METHOD("add_entity", "entity", "components", "add_to_tree"), &World::add_entity, DEFVAL(Variant()), DEFVAL(true));
+    ClassDB::bind_method(D_METHOD("add_entities", "entities"), &World::add_entities);
+    ClassDB::bind_method(D_METHOD("spawn_batch", "template", "count", "add_to_tree"), &World::spawn_batch, DEFVAL(true));
+    ClassDB::bind_method(D_METHOD("promote_entity", "entity"), &World::promote_entity);
     ClassDB::bind_method(D_METHOD("remove_entity", "entity"), &World::remove_entity);
+    ClassDB::bind_method(D_METHOD("remove_entities", "entities"), &World::remove_entities);
     ClassDB::bind_method(D_METHOD("disable_entity", "entity"), &World::disable_entity);
     ClassDB::bind_method(D_METHOD("enable_entity", "entity"), &World::enable_entity);
+    ClassDB::bind_method(D_METHOD("get_entities"), &World::get_entities);
+    ClassDB::bind_method(D_METHOD("get_entity_count"), &World::get_entity_count);
+    ClassDB::bind_method(D_METHOD("has_entity", "entity"), &World::has_entity);
+    ClassDB::bind_method(D_METHOD("get_entity", "handle"), &World::get_entity);
+    ClassDB::bind_method(D_METHOD("is_entity_handle_valid", "handle"), &World::is_entity_handle_valid);
+    ADD_PROPERTY(PropertyInfo(Variant::ARRAY, "entities", PROPERTY_HINT_NONE, "", PROPERTY_USAGE_NONE), "", "get_entities");
     ClassDB::bind_method(D_METHOD("add_system", "system", "topo_sort"), &World::add_system, DEFVAL(false));
     ClassDB::bind_method(D_METHOD("add_observer", "observer"), &World::add_observer);
     ClassDB::bind_method(D_METHOD("process", "delta", "group"), &World::process, DEFVAL(""));
@@ -37,11 +71,24 @@ void World::_bind_methods() {
     ClassDB::bind_method(D_METHOD("get_system_nodes_root"), &World::get_system_nodes_root);
     ADD_PROPERTY(PropertyInfo(Variant::NODE_PATH, "system_nodes_root", PROPERTY_HINT_NODE_PATH_VALID_TYPES, "Node"), "set_system_nodes_root", "get_system_nodes_root");
 
+    ClassDB::bind_method(D_METHOD("set_multithreaded", "enabled"), &World::set_multithreaded);
+    ClassDB::bind_method(D_METHOD("is_multithreaded"), &World::is_multithreaded);
+    ADD_PROPERTY(PropertyInfo(Variant::BOOL, "multithreaded"), "set_multithreaded", "is_multithreaded");
+    ClassDB::bind_method(D_METHOD("set_observer_coalescing", "enabled"), &World::set_observer_coalescing);
+    ClassDB::bind_method(D_METHOD("is_observer_coalescing"), &World::is_observer_coalescing);
+    ADD_PROPERTY(PropertyInfo(Variant::BOOL, "observer_coalescing"), "set_observer_coalescing", "is_observer_coalescing");
+
+    ClassDB::bind_method(D_METHOD("create_property_index", "component", "property"), &World::create_property_index);
+    ClassDB::bind_method(D_METHOD("remove_property_index", "component", "property"), &World::remove_property_index);
+    ClassDB::bind_method(D_METHOD("has_property_index", "component", "property"), &World::has_property_index);
+
     ClassDB::bind_method(D_METHOD("get_cache_stats"), &World::get_cache_stats);
     ClassDB::bind_method(D_METHOD("reset_cache_stats"), &World::reset_cache_stats);
 
     ADD_SIGNAL(MethodInfo("entity_added", PropertyInfo(Variant::OBJECT, "entity")));
     ADD_SIGNAL(MethodInfo("entity_removed", PropertyInfo(Variant::OBJECT, "entity")));
+    ADD_SIGNAL(MethodInfo("entities_added", PropertyInfo(Variant::ARRAY, "entities")));
+    ADD_SIGNAL(MethodInfo("entities_removed", PropertyInfo(Variant::ARRAY, "entities")));
     ADD_SIGNAL(MethodInfo("entity_disabled", PropertyInfo(Variant::OBJECT, "entity")));
     ADD_SIGNAL(MethodInfo("entity_enabled", PropertyInfo(Variant::OBJECT, "entity")));
     ADD_SIGNAL(MethodInfo("system_added", PropertyInfo(Variant::OBJECT, "system")));
@@ -51,12 +98,25 @@ void World::_bind_methods() {
     ADD_SIGNAL(MethodInfo("component_changed", PropertyInfo(Variant::OBJECT, "entity"), PropertyInfo(Variant::OBJECT, "component"), PropertyInfo(Variant::STRING, "property"), PropertyInfo(Variant::NIL, "new_value"), PropertyInfo(Variant::NIL, "old_value")));
     ADD_SIGNAL(MethodInfo("relationship_added", PropertyInfo(Variant::OBJECT, "entity"), PropertyInfo(Variant::OBJECT, "relationship")));
     ADD_SIGNAL(MethodInfo("relationship_removed", PropertyInfo(Variant::OBJECT, "entity"), PropertyInfo(Variant::OBJECT, "relationship")));
-    ADD_SIGNAL(MethodInfo("cache_invalidated"));
+    ADD_SIGNAL(MethodInfo("cache_invalidated", PropertyInfo(Variant::STRING, "cause")));
 }
 
 void World::_notification(int p_what) {
     if (p_what == NOTIFICATION_READY && !Engine::get_singleton()->is_editor_hint()) {
         initialize();
+    } else if (p_what == NOTIFICATION_PREDELETE) {
+        // Virtual entities have no parent node to free them along with the world.
+        LocalVector<Entity *> virtual_entities;
+        const LocalVector<Entity *> &attached = entities.get_entities();
+        for (uint32_t i = 0; i < attached.size(); ++i) {
+            if (!attached[i]->is_inside_tree()) {
+                virtual_entities.push_back(attached[i]);
+            }
+        }
+        _clear_storage();
+        for (uint32_t i = 0; i < virtual_entities.size(); ++i) {
+            virtual_entities[i]->queue_free();
+        }
     }
 }
 
@@ -96,32 +156,32 @@ void World::initialize() {
     }
 }
 
-void World::add_entity(Entity *entity) {
+void World::add_entity(Entity *entity, const Variant &components, bool add_to_tree) {
     if (!entity) return;
-    Node* ent_root = get_node<Node>(entity_nodes_root);
-    if (ent_root && !entity->is_inside_tree()) {
-        ent_root->add_child(entity);
+    if (SystemScheduler::is_worker_thread()) {
+        SystemScheduler::defer_call(Callable(this, "add_entity").bind(entity, components, add_to_tree));
+        return;
+    }
+    _place_entity(entity, add_to_tree ? get_node<Node>(entity_nodes_root) : nullptr);
+
+    if (entity->world && entity->world != this) {
+        entity->world->_detach_entity(entity);
+    }
+    if (!entity->world) {
+        _attach_entity(entity);
+    }
+
+    if (components.get_type() == Variant::ARRAY) {
+        entity->add_components(components);
     }
 
-    int64_t id = entity->get_instance_id();
-    entities[id] = entity;
-    
     emit_signal("entity_added", entity);
 
     entity->connect("component_added", callable_mp(this, &World::_on_entity_component_added));
     entity->connect("component_removed", callable_mp(this, &World::_on_entity_component_removed));
     entity->connect("component_property_changed", callable_mp(this, &World::_on_entity_component_property_changed));
-    
-    TypedArray<Component> existing_components = entity->get_component_resources();
-    for (int i = 0; i < existing_components.size(); i++) {
-        Ref<Component> comp = existing_components[i];
-        if (comp.is_valid()) {
-            Ref<Script> scr = comp->get_script();
-            if(scr.is_valid()) {
-                _add_entity_to_index(entity, scr->get_path());
-            }
-        }
-    }
+    entity->connect("relationship_added", callable_mp(this, &World::_on_entity_relationship_added));
+    entity->connect("relationship_removed", callable_mp(this, &World::_on_entity_relationship_removed));
 
     GECS* ecs = GECS::get_singleton();
     if(ecs) {
@@ -134,21 +194,171 @@ void World::add_entity(Entity *entity) {
         }
     }
     
-    _query_result_cache.clear();
-    emit_signal("cache_invalidated");
 }
 
 void World::add_entities(const Array &p_entities) {
+    if (SystemScheduler::is_worker_thread()) {
+        SystemScheduler::defer_call(Callable(this, "add_entities").bind(p_entities));
+        return;
+    }
+    LocalVector<Entity *> batch;
+    batch.reserve(p_entities.size());
     for (int i = 0; i < p_entities.size(); ++i) {
         Entity *entity = Object::cast_to<Entity>(p_entities[i]);
         if (entity) {
-            add_entity(entity);
+            batch.push_back(entity);
+        }
+    }
+    _add_entities(batch, true, true);
+}
+
+Array World::spawn_batch(Object *p_template, int p_count, bool add_to_tree) {
+    Array spawned;
+    if (!p_template || p_count <= 0) return spawned;
+    if (SystemScheduler::is_worker_thread()) {
+        UtilityFunctions::push_error("spawn_batch() can't run on a worker thread; record the spawns in the system's cmd instead.");
+        return spawned;
+    }
+
+    Prefab *prefab = Object::cast_to<Prefab>(p_template);
+    Entity *template_entity = Object::cast_to<Entity>(p_template);
+    if (!prefab && !template_entity) {
+        UtilityFunctions::push_error("spawn_batch() template must be an Entity or a Prefab.");
+        return spawned;
+    }
+
+    // Components added in code live on the template itself; component_resources
+    // come along with the node and are instanced when each copy becomes ready.
+    // A template that already instanced them holds the full set, runtime edits
+    // included, so its copies take that set and skip defining components again.
+    bool template_defined = template_entity && template_entity->components_defined;
+    Array template_components = template_entity ? template_entity->get_components() : Array();
+    LocalVector<ComponentTemplate> component_templates;
+    component_templates.resize(template_components.size());
+    for (int c = 0; c < template_components.size(); ++c) {
+        component_templates[c].build(template_components[c]);
+    }
+    LocalVector<Entity *> batch;
+    batch.reserve(p_count);
+    spawned.resize(p_count);
+    for (int i = 0; i < p_count; ++i) {
+        if (prefab) {
+            Entity *entity = prefab->instantiate();
+            batch.push_back(entity);
+            spawned[i] = entity;
+            continue;
+        }
+        Entity *entity = Object::cast_to<Entity>(template_entity->duplicate());
+        if (!entity) {
+            UtilityFunctions::push_error("spawn_batch() could not duplicate the template entity.");
+            spawned.resize(i);
+            break;
         }
+        entity->components_defined = template_defined;
+        for (int c = 0; c < template_components.size(); ++c) {
+            Ref<Component> component = template_components[c];
+            if (component->is_shared()) {
+                entity->add_component(component);
+            } else if (component_templates[c].script.is_valid()) {
+                entity->add_component(component_templates[c].instantiate());
+            } else {
+                entity->add_component(component->duplicate());
+            }
+        }
+        batch.push_back(entity);
+        spawned[i] = entity;
+    }
+
+    _add_entities(batch, false, add_to_tree);
+    emit_signal("entities_added", spawned);
+    return spawned;
+}
+
+void World::_add_entities(const LocalVector<Entity *> &p_entities, bool p_emit_each, bool p_add_to_tree) {
+    Node* ent_root = p_add_to_tree ? get_node<Node>(entity_nodes_root) : nullptr;
+    LocalVector<Entity *> attached;
+    LocalVector<Archetype *> targets;
+    attached.reserve(p_entities.size());
+    targets.reserve(p_entities.size());
+    for (uint32_t i = 0; i < p_entities.size(); ++i) {
+        Entity *entity = p_entities[i];
+        _place_entity(entity, ent_root);
+        if (entity->world && entity->world != this) {
+            entity->world->_detach_entity(entity);
+        }
+        if (!entity->world) {
+            attached.push_back(entity);
+            targets.push_back(_detached_archetype(entity));
+        }
+    }
+
+    // Size every table once, then store the rows and update the query cache in one pass.
+    HashMap<Archetype *, uint32_t> row_counts;
+    for (uint32_t i = 0; i < targets.size(); ++i) {
+        uint32_t *count = row_counts.getptr(targets[i]);
+        if (count) {
+            (*count)++;
+        } else {
+            row_counts.insert(targets[i], 1);
+        }
+    }
+    for (const KeyValue<Archetype *, uint32_t> &E : row_counts) {
+        E.key->reserve(E.value);
+    }
+    entities.reserve(attached.size());
+    for (uint32_t i = 0; i < attached.size(); ++i) {
+        _store_entity(attached[i], targets[i]);
+    }
+    _cache_batch(attached, true);
+    _emit_cache_invalidated();
+
+    GECS* ecs = GECS::get_singleton();
+    Array preprocessors = ecs ? ecs->get_entity_preprocessors() : Array();
+    for (uint32_t i = 0; i < p_entities.size(); ++i) {
+        Entity *entity = p_entities[i];
+        if (p_emit_each) {
+            emit_signal("entity_added", entity);
+        }
+
+        entity->connect("component_added", callable_mp(this, &World::_on_entity_component_added));
+        entity->connect("component_removed", callable_mp(this, &World::_on_entity_component_removed));
+        entity->connect("component_property_changed", callable_mp(this, &World::_on_entity_component_property_changed));
+        entity->connect("relationship_added", callable_mp(this, &World::_on_entity_relationship_added));
+        entity->connect("relationship_removed", callable_mp(this, &World::_on_entity_relationship_removed));
+
+        for (int j = 0; j < preprocessors.size(); j++) {
+            Callable c = preprocessors[j];
+            Array args;
+            args.push_back(entity);
+            c.callv(args);
+        }
+    }
+}
+
+void World::_place_entity(Entity *entity, Node *p_root) {
+    if (entity->is_inside_tree()) return;
+    if (p_root) {
+        p_root->add_child(entity);
+    } else {
+        // Virtual entity: no scene presence, so it never gets NOTIFICATION_READY.
+        entity->_initialize();
+    }
+}
+
+void World::promote_entity(Entity *entity) {
+    if (!entity || entity->world != this || entity->is_inside_tree()) return;
+    Node* ent_root = get_node<Node>(entity_nodes_root);
+    if (ent_root) {
+        ent_root->add_child(entity);
     }
 }
 
 void World::remove_entity(Entity *entity) {
     if (!entity) return;
+    if (SystemScheduler::is_worker_thread()) {
+        SystemScheduler::defer_call(Callable(this, "remove_entity").bind(entity));
+        return;
+    }
 
     GECS* ecs = GECS::get_singleton();
     if(ecs) {
@@ -162,28 +372,74 @@ void World::remove_entity(Entity *entity) {
     }
 
     emit_signal("entity_removed", entity);
-    
-    int64_t id = entity->get_instance_id();
-    entities.erase(id);
-    TypedArray<Component> existing_components = entity->get_component_resources();
-    for (int i = 0; i < existing_components.size(); i++) {
-        Ref<Component> comp = existing_components[i];
-        if (comp.is_valid()) {
-            Ref<Script> scr = comp->get_script();
-            if (scr.is_valid()) {
-                _remove_entity_from_index(entity, scr->get_path());
-            }
-        }
-    }
+
+    _remove_relationships_to(entity);
+    _detach_entity(entity);
+    _emit_cache_invalidated();
 
     entity->disconnect("component_added", callable_mp(this, &World::_on_entity_component_added));
     entity->disconnect("component_removed", callable_mp(this, &World::_on_entity_component_removed));
     entity->disconnect("component_property_changed", callable_mp(this, &World::_on_entity_component_property_changed));
+    entity->disconnect("relationship_added", callable_mp(this, &World::_on_entity_relationship_added));
+    entity->disconnect("relationship_removed", callable_mp(this, &World::_on_entity_relationship_removed));
     entity->on_destroy();
     entity->queue_free();
-    
-    _query_result_cache.clear();
-    emit_signal("cache_invalidated");
+}
+
+void World::remove_entities(const Array &p_entities) {
+    if (SystemScheduler::is_worker_thread()) {
+        SystemScheduler::defer_call(Callable(this, "remove_entities").bind(p_entities));
+        return;
+    }
+    LocalVector<Entity *> batch;
+    Array removed;
+    for (int i = 0; i < p_entities.size(); ++i) {
+        Entity *entity = Object::cast_to<Entity>(p_entities[i]);
+        if (entity) {
+            batch.push_back(entity);
+            removed.push_back(entity);
+        }
+    }
+    if (batch.is_empty()) return;
+
+    GECS* ecs = GECS::get_singleton();
+    if (ecs) {
+        Array postprocessors = ecs->get_entity_postprocessors();
+        for (uint32_t i = 0; i < batch.size(); i++) {
+            for (int j = 0; j < postprocessors.size(); j++) {
+                Callable c = postprocessors[j];
+                Array args;
+                args.push_back(batch[i]);
+                c.callv(args);
+            }
+        }
+    }
+
+    emit_signal("entities_removed", removed);
+    for (uint32_t i = 0; i < batch.size(); i++) {
+        _remove_relationships_to(batch[i]);
+    }
+
+    LocalVector<Entity *> attached;
+    for (uint32_t i = 0; i < batch.size(); i++) {
+        if (batch[i]->world == this && batch[i]->archetype) {
+            attached.push_back(batch[i]);
+        }
+    }
+    _cache_batch(attached, false);
+    _emit_cache_invalidated();
+
+    for (uint32_t i = 0; i < batch.size(); i++) {
+        Entity *entity = batch[i];
+        _detach_entity(entity, false);
+        entity->disconnect("component_added", callable_mp(this, &World::_on_entity_component_added));
+        entity->disconnect("component_removed", callable_mp(this, &World::_on_entity_component_removed));
+        entity->disconnect("component_property_changed", callable_mp(this, &World::_on_entity_component_property_changed));
+        entity->disconnect("relationship_added", callable_mp(this, &World::_on_entity_relationship_added));
+        entity->disconnect("relationship_removed", callable_mp(this, &World::_on_entity_relationship_removed));
+        entity->on_destroy();
+        entity->queue_free();
+    }
 }
 
 void World::disable_entity(Entity *entity) {
@@ -198,9 +454,6 @@ void World::disable_entity(Entity *entity) {
     entity->on_disable();
     entity->set_process(false);
     entity->set_physics_process(false);
-
-    _query_result_cache.clear();
-    emit_signal("cache_invalidated");
 }
 
 void World::enable_entity(Entity *entity) {
@@ -215,9 +468,6 @@ void World::enable_entity(Entity *entity) {
     entity->on_enable();
     entity->set_process(true);
     entity->set_physics_process(true);
-
-    _query_result_cache.clear();
-    emit_signal("cache_invalidated");
 }
 
 void World::add_system(System *system, bool topo_sort) {
@@ -235,6 +485,7 @@ void World::add_system(System *system, bool topo_sort) {
     group_systems.push_back(system);
     systems_by_group[group] = group_systems;
     
+    system->_set_world(this);
     system->set_q(get_query());
     system->setup();
     if (topo_sort) {
@@ -281,6 +532,16 @@ void World::add_observer(Observer *observer) {
     }
     observer->set_q(get_query());
     observers.push_back(observer);
+
+    int type_id = observer->_resolve();
+    if (type_id < 0) return;
+    if ((uint32_t)type_id >= observer_type_index.size()) {
+        observer_type_index.resize(type_id + 1);
+    }
+    LocalVector<uint64_t> &watchers = observer_type_index[type_id];
+    if (watchers.find(observer->get_instance_id()) < 0) {
+        watchers.push_back(observer->get_instance_id());
+    }
 }
 
 void World::add_observers(const Array &p_observers) {
@@ -295,11 +556,14 @@ void World::add_observers(const Array &p_observers) {
 void World::remove_observer(Observer *observer) {
     if (!observer) return;
     observers.erase(observer);
+    for (uint32_t i = 0; i < observer_type_index.size(); i++) {
+        observer_type_index[i].erase(observer->get_instance_id());
+    }
     observer->queue_free();
 }
 
 void World::purge(bool should_free) {
-    Array entity_values = entities.values();
+    Array entity_values = get_entities();
     for (int i = 0; i < entity_values.size(); ++i) {
         remove_entity(Object::cast_to<Entity>(entity_values[i]));
     }
@@ -323,40 +587,66 @@ void World::purge(bool should_free) {
 
 void World::process(double delta, const String &group) {
     if (systems_by_group.has(group)) {
-        Array group_systems = systems_by_group[group];
-        for (int i = 0; i < group_systems.size(); i++) {
-            System *system = Object::cast_to<System>(group_systems[i]);
-            if (system && system->get_active() && !system->get_paused()) {
-                system->_handle(delta);
-            }
-        }
+        scheduler.run(systems_by_group[group], delta, multithreaded);
     }
     _process_observer_queue();
 }
 
+void World::set_multithreaded(bool p_multithreaded) {
+    multithreaded = p_multithreaded;
+}
+
+bool World::is_multithreaded() const {
+    return multithreaded;
+}
+
+void World::set_observer_coalescing(bool p_coalescing) {
+    std::lock_guard<std::mutex> lock(_sync_mutex);
+    _observer_queue.set_coalescing(p_coalescing);
+}
+
+bool World::is_observer_coalescing() const {
+    return _observer_queue.is_coalescing();
+}
+
 void World::_process_observer_queue() {
-    if (_processing_observers || _observer_queue.is_empty()) {
+    if (_processing_observers) {
+        return;
+    }
+    uint32_t pending;
+    {
+        std::lock_guard<std::mutex> lock(_sync_mutex);
+        pending = _observer_queue.size();
+    }
+    if (pending == 0) {
         return;
     }
     _processing_observers = true;
-    Array current_queue = _observer_queue;
-    _observer_queue.clear();
-    for (int i = 0; i < current_queue.size(); i++) {
-        Dictionary event = current_queue[i];
-        String type = event["type"];
-        
-        Entity* entity = Object::cast_to<Entity>(event["entity"]);
-        Component* component = Object::cast_to<Component>(event["component"]);
+    // Events queued by the callbacks themselves wait for the next pass.
+    ObserverEventQueue::Event event;
+    for (uint32_t i = 0; i < pending; i++) {
+        {
+            std::lock_guard<std::mutex> lock(_sync_mutex);
+            if (!_observer_queue.pop(event)) {
+                break;
+            }
+        }
+        Entity *entity = Object::cast_to<Entity>(ObjectDB::get_instance(event.entity));
+        Component *component = event.component.ptr();
         if (!entity || !component) {
             continue;
         }
 
-        if (type == "component_added") {
-            _handle_observer_component_added(entity, component);
-        } else if (type == "component_removed") {
-            _handle_observer_component_removed(entity, component);
-        } else if (type == "component_changed") {
-            _handle_observer_component_changed(entity, component, event["property"], event["new_value"], event["old_value"]);
+        switch (event.type) {
+            case ObserverEventQueue::COMPONENT_ADDED:
+                _handle_observer_component_added(entity, component);
+                break;
+            case ObserverEventQueue::COMPONENT_REMOVED:
+                _handle_observer_component_removed(entity, component);
+                break;
+            case ObserverEventQueue::COMPONENT_CHANGED:
+                _handle_observer_component_changed(entity, component, event.property, event.new_value, event.old_value);
+                break;
         }
     }
     _processing_observers = false;
@@ -366,173 +656,763 @@ Ref<QueryBuilder> World::get_query() {
     Ref<QueryBuilder> qb;
     qb.instantiate();
     qb->_init(this);
-    connect("cache_invalidated", callable_mp(qb.ptr(), &QueryBuilder::invalidate_cache));
     return qb;
 }
 
-String World::_generate_query_cache_key(const Array &all_comps, const Array &any_comps, const Array &none_comps) {
-    Array all_paths, any_paths, none_paths;
-    for(int i = 0; i < all_comps.size(); i++) {
-        Ref<Script> scr = all_comps[i];
-        if (scr.is_valid()) all_paths.push_back(scr->get_path());
+bool World::_build_component_mask(const Array &p_components, ComponentMask &r_mask) {
+    bool has_types = false;
+    for (int i = 0; i < p_components.size(); ++i) {
+        Variant element = p_components[i];
+        if (element.get_type() == Variant::DICTIONARY) {
+            // Value queries ({C_Type: {...}}) still require the component to be present.
+            Array types = Dictionary(element).keys();
+            for (int j = 0; j < types.size(); ++j) {
+                int type_id = GECS::get_component_type_id_for_object(types[j]);
+                if (type_id >= 0) {
+                    r_mask.set(type_id);
+                    has_types = true;
+                }
+            }
+            continue;
+        }
+        Object *type = element;
+        int type_id = GECS::get_component_type_id_for_object(type);
+        if (type_id >= 0) {
+            r_mask.set(type_id);
+            has_types = true;
+        }
     }
-    for(int i = 0; i < any_comps.size(); i++) {
-        Ref<Script> scr = any_comps[i];
-        if (scr.is_valid()) any_paths.push_back(scr->get_path());
+    return has_types;
+}
+
+void World::_make_query_key(const Array &all_comps, const Array &any_comps, const Array &none_comps, QueryCacheKey &r_key) {
+    _build_component_mask(all_comps, r_key.all);
+    r_key.any_filter = _build_component_mask(any_comps, r_key.any) || !any_comps.is_empty();
+    _build_component_mask(none_comps, r_key.none);
+}
+
+void World::_query_archetypes(const Array &all_comps, const Array &any_comps, const Array &none_comps, LocalVector<Archetype *> &r_archetypes) {
+    QueryCacheKey key;
+    _make_query_key(all_comps, any_comps, none_comps, key);
+    _query_archetypes(key, r_archetypes);
+}
+
+void World::_query_archetypes(const QueryCacheKey &p_key, LocalVector<Archetype *> &r_archetypes) {
+    // Only archetypes holding the rarest required component can match.
+    const LocalVector<Archetype *> *candidates = &archetype_list;
+    LocalVector<int> required;
+    p_key.all.get_ids(required);
+    for (uint32_t i = 0; i < required.size(); ++i) {
+        if (uint32_t(required[i]) >= component_archetype_index.size()) {
+            return;
+        }
+        const LocalVector<Archetype *> &with_comp = component_archetype_index[required[i]];
+        if (with_comp.size() < candidates->size()) {
+            candidates = &with_comp;
+        }
     }
-    for(int i = 0; i < none_comps.size(); i++) {
-        Ref<Script> scr = none_comps[i];
-        if (scr.is_valid()) none_paths.push_back(scr->get_path());
+
+    for (uint32_t a = 0; a < candidates->size(); ++a) {
+        Archetype *archetype = (*candidates)[a];
+        if (archetype->size() > 0 && p_key.matches(archetype->mask)) {
+            r_archetypes.push_back(archetype);
+        }
     }
-    
-    all_paths.sort();
-    any_paths.sort();
-    none_paths.sort();
-    return "ALL:" + String(",").join(all_paths) + "|ANY:" + String(",").join(any_paths) + "|NONE:" + String(",").join(none_paths);
 }
 
 Array World::_query(const Array &all_comps, const Array &any_comps, const Array &none_comps) {
-    if (all_comps.is_empty() && any_comps.is_empty() && none_comps.is_empty()) {
-        return entities.values();
+    QueryCacheKey key;
+    _make_query_key(all_comps, any_comps, none_comps, key);
+    return _query(key);
+}
+
+Array World::_query(const QueryCacheKey &p_key, uint64_t *r_version) {
+    std::lock_guard<std::mutex> lock(_sync_mutex);
+    CachedQuery **cached = _query_result_cache.getptr(p_key);
+    if (cached) {
+        _cache_hits++;
+        (*cached)->shared = true;
+        if (r_version) {
+            *r_version = (*cached)->version;
+        }
+        return (*cached)->result;
     }
-    
-    String cache_key = _generate_query_cache_key(all_comps, any_comps, none_comps);
-    if (_query_result_cache.has(cache_key)) {
-        return _query_result_cache[cache_key];
+    _cache_misses++;
+
+    LocalVector<Archetype *> matched;
+    _query_archetypes(p_key, matched);
+
+    CachedQuery *query = memnew(CachedQuery);
+    query->key = p_key;
+    query->version = ++_query_version;
+
+    int64_t total = 0;
+    for (uint32_t a = 0; a < matched.size(); ++a) {
+        total += matched[a]->size();
     }
-    
-    Array result;
-    bool has_all_filter = !all_comps.is_empty();
-    if (has_all_filter) {
-        Ref<Script> smallest_set_script;
-        int smallest_size = -1;
-        for (int i = 0; i < all_comps.size(); ++i) {
-            Ref<Script> script = all_comps[i];
-            if (script.is_null()) continue;
-            String path = script->get_path();
-            if (!component_entity_index.has(path)) {
-                _query_result_cache[cache_key] = Array();
-                return Array();
-            }
-            Array entities_with_comp = component_entity_index[path];
-            if (smallest_size == -1 || entities_with_comp.size() < smallest_size) {
-                smallest_size = entities_with_comp.size();
-                smallest_set_script = script;
-            }
+    query->result.resize(total);
+    query->positions.reserve(total);
+    int64_t index = 0;
+    for (uint32_t a = 0; a < matched.size(); ++a) {
+        const LocalVector<Entity *> &rows = matched[a]->entities;
+        for (uint32_t row = 0; row < rows.size(); ++row) {
+            query->positions.insert(rows[row], index);
+            query->result[index++] = rows[row];
         }
-        
-        if (smallest_set_script.is_null()) {
-            _query_result_cache[cache_key] = Array();
-            return Array();
+    }
+
+    _query_result_cache.insert(p_key, query);
+    _cached_queries.push_back(query);
+    LocalVector<int> involved;
+    p_key.all.get_ids(involved);
+    p_key.any.get_ids(involved);
+    p_key.none.get_ids(involved);
+    for (uint32_t i = 0; i < involved.size(); ++i) {
+        int type_id = involved[i];
+        if (uint32_t(type_id) >= _cached_queries_by_type.size()) {
+            _cached_queries_by_type.resize(type_id + 1);
         }
+        _cached_queries_by_type[type_id].push_back(query);
+    }
 
-        result = component_entity_index[smallest_set_script->get_path()].duplicate();
-        for (int i = 0; i < all_comps.size(); ++i) {
-            Ref<Script> script = all_comps[i];
-            if (script.is_null() || script == smallest_set_script) continue;
-            result = GECS::intersect(result, component_entity_index[script->get_path()]);
-            if (result.is_empty()) {
-                _query_result_cache[cache_key] = Array();
-                return Array();
-            }
+    query->shared = true;
+    if (r_version) {
+        *r_version = query->version;
+    }
+    return query->result;
+}
+
+void World::_cache_insert(CachedQuery *p_query, Entity *entity, InvalidationCause p_cause) {
+    if (p_query->positions.has(entity)) return;
+    if (p_query->shared) {
+        p_query->result = p_query->result.duplicate();
+        p_query->shared = false;
+    }
+    p_query->positions.insert(entity, p_query->result.size());
+    p_query->result.push_back(entity);
+    p_query->version = ++_query_version;
+    _invalidations[p_cause]++;
+    _pending_invalidations |= 1u << p_cause;
+}
+
+void World::_cache_erase(CachedQuery *p_query, Entity *entity, InvalidationCause p_cause) {
+    int64_t *position = p_query->positions.getptr(entity);
+    if (!position) return;
+    if (p_query->shared) {
+        p_query->result = p_query->result.duplicate();
+        p_query->shared = false;
+    }
+    int64_t index = *position;
+    int64_t last = p_query->result.size() - 1;
+    if (index != last) {
+        Entity *moved = Object::cast_to<Entity>(p_query->result[last]);
+        p_query->result[index] = moved;
+        p_query->positions[moved] = index;
+    }
+    p_query->result.resize(last);
+    p_query->positions.erase(entity);
+    p_query->version = ++_query_version;
+    _invalidations[p_cause]++;
+    _pending_invalidations |= 1u << p_cause;
+}
+
+void World::_cache_add_entity(Entity *entity) {
+    const ComponentMask &mask = entity->archetype->mask;
+    for (uint32_t i = 0; i < _cached_queries.size(); ++i) {
+        if (_cached_queries[i]->key.matches(mask)) {
+            _cache_insert(_cached_queries[i], entity, INVALIDATION_ENTITY_ADDED);
         }
     }
-    
-    if (!any_comps.is_empty()) {
-        Array any_result;
-        for (int i = 0; i < any_comps.size(); ++i) {
-            Ref<Script> script = any_comps[i];
-            if (script.is_null()) continue;
-            String path = script->get_path();
-            if (component_entity_index.has(path)) {
-                any_result = GECS::union_arrays(any_result, component_entity_index[path]);
+}
+
+void World::_cache_batch(const LocalVector<Entity *> &p_entities, bool p_added) {
+    // A batch usually spans a handful of archetypes: match each query once per archetype.
+    LocalVector<Archetype *> batch_archetypes;
+    LocalVector<uint32_t> entity_archetypes;
+    entity_archetypes.resize(p_entities.size());
+    for (uint32_t i = 0; i < p_entities.size(); ++i) {
+        int64_t index = batch_archetypes.find(p_entities[i]->archetype);
+        if (index < 0) {
+            index = batch_archetypes.size();
+            batch_archetypes.push_back(p_entities[i]->archetype);
+        }
+        entity_archetypes[i] = uint32_t(index);
+    }
+
+    LocalVector<uint8_t> matched;
+    matched.resize(batch_archetypes.size());
+    for (uint32_t q = 0; q < _cached_queries.size(); ++q) {
+        CachedQuery *query = _cached_queries[q];
+        bool any = false;
+        for (uint32_t a = 0; a < batch_archetypes.size(); ++a) {
+            matched[a] = query->key.matches(batch_archetypes[a]->mask);
+            any = any || matched[a];
+        }
+        if (!any) continue;
+        if (p_added) {
+            query->positions.reserve(query->positions.size() + p_entities.size());
+        }
+        for (uint32_t i = 0; i < p_entities.size(); ++i) {
+            if (!matched[entity_archetypes[i]]) continue;
+            if (p_added) {
+                _cache_insert(query, p_entities[i], INVALIDATION_ENTITY_ADDED);
+            } else {
+                _cache_erase(query, p_entities[i], INVALIDATION_ENTITY_REMOVED);
             }
         }
-        if (has_all_filter) {
-            result = GECS::intersect(result, any_result);
+    }
+}
+
+void World::_cache_remove_entity(Entity *entity) {
+    for (uint32_t i = 0; i < _cached_queries.size(); ++i) {
+        _cache_erase(_cached_queries[i], entity, INVALIDATION_ENTITY_REMOVED);
+    }
+}
+
+void World::_cache_update_entity(Entity *entity, int type_id, const ComponentMask &p_old_mask, const ComponentMask &p_new_mask) {
+    // Only queries mentioning the changed type can flip for this entity.
+    if (uint32_t(type_id) >= _cached_queries_by_type.size()) return;
+    const LocalVector<CachedQuery *> &affected = _cached_queries_by_type[type_id];
+    for (uint32_t i = 0; i < affected.size(); ++i) {
+        CachedQuery *query = affected[i];
+        bool was_match = query->key.matches(p_old_mask);
+        bool is_match = query->key.matches(p_new_mask);
+        if (is_match && !was_match) {
+            _cache_insert(query, entity, p_new_mask.has(type_id) ? INVALIDATION_COMPONENT_ADDED : INVALIDATION_COMPONENT_REMOVED);
+        } else if (was_match && !is_match) {
+            _cache_erase(query, entity, p_new_mask.has(type_id) ? INVALIDATION_COMPONENT_ADDED : INVALIDATION_COMPONENT_REMOVED);
+        }
+    }
+}
+
+// Once per cause since the last call, after the cache has caught up, so
+// listeners never see a half-applied batch.
+void World::_emit_cache_invalidated() {
+    uint32_t pending = _pending_invalidations;
+    _pending_invalidations = 0;
+    for (int i = 0; i < INVALIDATION_MAX; i++) {
+        if (pending & (1u << i)) {
+            emit_signal("cache_invalidated", String(invalidation_names[i]));
+        }
+    }
+}
+
+void World::_clear_query_cache() {
+    for (uint32_t i = 0; i < _cached_queries.size(); ++i) {
+        memdelete(_cached_queries[i]);
+    }
+    _cached_queries.clear();
+    _cached_queries_by_type.clear();
+    _query_result_cache.clear();
+}
+
+uint64_t World::_watch_property(const PropertyKey &p_key) {
+    std::lock_guard<std::mutex> lock(_sync_mutex);
+    uint64_t *version = _property_versions.getptr(p_key);
+    if (version) {
+        return *version;
+    }
+    _property_versions.insert(p_key, 0);
+    return 0;
+}
+
+uint64_t World::_get_property_version(const PropertyKey &p_key) const {
+    std::lock_guard<std::mutex> lock(_sync_mutex);
+    const uint64_t *version = _property_versions.getptr(p_key);
+    return version ? *version : 0;
+}
+
+uint64_t World::_next_change_tick() {
+    return _change_tick.fetch_add(1) + 1;
+}
+
+uint64_t World::_get_change_tick() const {
+    return system_tick ? system_tick : _change_tick.load() + 1;
+}
+
+Archetype *World::_get_or_create_archetype(const LocalVector<int> &p_sorted_types) {
+    ComponentMask mask;
+    for (uint32_t i = 0; i < p_sorted_types.size(); ++i) {
+        mask.set(p_sorted_types[i]);
+    }
+    Archetype **existing = archetypes.getptr(mask);
+    if (existing) {
+        return *existing;
+    }
+
+    Archetype *archetype = memnew(Archetype(p_sorted_types));
+    archetypes.insert(mask, archetype);
+    archetype_list.push_back(archetype);
+    for (uint32_t i = 0; i < p_sorted_types.size(); ++i) {
+        int type_id = p_sorted_types[i];
+        if (uint32_t(type_id) >= component_archetype_index.size()) {
+            component_archetype_index.resize(type_id + 1);
+        }
+        component_archetype_index[type_id].push_back(archetype);
+    }
+    return archetype;
+}
+
+Archetype *World::_archetype_with(Archetype *p_archetype, int p_type_id) {
+    Archetype **edge = p_archetype->add_edges.getptr(p_type_id);
+    if (edge) {
+        return *edge;
+    }
+
+    LocalVector<int> types = p_archetype->types;
+    types.push_back(p_type_id);
+    types.sort();
+    Archetype *target = _get_or_create_archetype(types);
+    p_archetype->add_edges[p_type_id] = target;
+    target->remove_edges[p_type_id] = p_archetype;
+    return target;
+}
+
+Archetype *World::_archetype_without(Archetype *p_archetype, int p_type_id) {
+    Archetype **edge = p_archetype->remove_edges.getptr(p_type_id);
+    if (edge) {
+        return *edge;
+    }
+
+    LocalVector<int> types;
+    for (uint32_t i = 0; i < p_archetype->types.size(); ++i) {
+        if (p_archetype->types[i] != p_type_id) {
+            types.push_back(p_archetype->types[i]);
+        }
+    }
+    Archetype *target = _get_or_create_archetype(types);
+    p_archetype->remove_edges[p_type_id] = target;
+    target->add_edges[p_type_id] = p_archetype;
+    return target;
+}
+
+void World::_move_entity(Entity *entity, Archetype *p_target) {
+    Archetype *source = entity->archetype;
+    uint32_t source_row = entity->archetype_row;
+
+    uint32_t row = p_target->add_row(entity);
+    for (uint32_t c = 0; c < p_target->types.size(); ++c) {
+        int source_column = source->get_column(p_target->types[c]);
+        if (source_column >= 0) {
+            p_target->columns[c][row] = source->columns[source_column][source_row];
+        }
+    }
+
+    Entity *moved = source->remove_row(source_row);
+    if (moved) {
+        moved->archetype_row = source_row;
+    }
+    entity->archetype = p_target;
+    entity->archetype_row = row;
+}
+
+Archetype *World::_detached_archetype(Entity *entity) {
+    LocalVector<int> types;
+    for (const KeyValue<int, Ref<Component>> &E : entity->components) {
+        types.push_back(E.key);
+    }
+    types.sort();
+    return _get_or_create_archetype(types);
+}
+
+void World::_attach_entity(Entity *entity) {
+    _store_entity(entity, _detached_archetype(entity));
+    _cache_add_entity(entity);
+}
+
+void World::_store_entity(Entity *entity, Archetype *archetype) {
+    uint32_t row = archetype->add_row(entity);
+    for (const KeyValue<int, Ref<Component>> &E : entity->components) {
+        archetype->set_component(row, archetype->get_column(E.key), E.value);
+    }
+    if (!_property_indexes.is_empty()) {
+        for (const KeyValue<int, Ref<Component>> &E : entity->components) {
+            _index_component(entity, E.key, E.value);
+        }
+    }
+
+    for (const KeyValue<int, Ref<Component>> &E : entity->components) {
+        _mark_added(E.value);
+    }
+
+    for (int i = 0; i < entity->relationships.size(); i++) {
+        Ref<Relationship> relationship = entity->relationships[i];
+        if (relationship.is_valid()) {
+            _relationship_index.add(entity, relationship);
+        }
+    }
+    if (!entity->relationships.is_empty()) {
+        _relationship_version++;
+    }
+
+    entity->components.clear();
+    entity->signature.clear();
+    entity->world = this;
+    entity->archetype = archetype;
+    entity->archetype_row = row;
+    entity->handle = entities.add(entity);
+    entity_list_dirty = true;
+}
+
+void World::_restore_detached_components(Entity *entity) {
+    Archetype *archetype = entity->archetype;
+    uint32_t row = entity->archetype_row;
+    for (uint32_t c = 0; c < archetype->types.size(); ++c) {
+        entity->components[archetype->types[c]] = archetype->columns[c][row];
+    }
+    entity->signature = archetype->mask;
+    entity->world = nullptr;
+    entity->archetype = nullptr;
+    entity->archetype_row = 0;
+    entity->handle = EntityTable::INVALID_HANDLE;
+}
+
+void World::_detach_entity(Entity *entity, bool p_update_cache) {
+    if (entity->world != this || !entity->archetype) return;
+
+    if (p_update_cache) {
+        _cache_remove_entity(entity);
+    }
+    entities.remove(entity->handle);
+    entity_list_dirty = true;
+
+    Archetype *archetype = entity->archetype;
+    uint32_t row = entity->archetype_row;
+    if (!_property_indexes.is_empty()) {
+        for (uint32_t c = 0; c < archetype->types.size(); ++c) {
+            _unindex_component(entity, archetype->types[c]);
+        }
+    }
+    for (int i = 0; i < entity->relationships.size(); i++) {
+        Ref<Relationship> relationship = entity->relationships[i];
+        if (relationship.is_valid()) {
+            _relationship_index.remove(entity, relationship);
+        }
+    }
+    if (!entity->relationships.is_empty()) {
+        _relationship_version++;
+    }
+    _restore_detached_components(entity);
+
+    Entity *moved = archetype->remove_row(row);
+    if (moved) {
+        moved->archetype_row = row;
+    }
+}
+
+void World::_set_entity_component(Entity *entity, int type_id, const Ref<Component> &component) {
+    Archetype *archetype = entity->archetype;
+    int column = archetype->get_column(type_id);
+    if (column < 0) {
+        Archetype *source = archetype;
+        archetype = _archetype_with(source, type_id);
+        _move_entity(entity, archetype);
+        _cache_update_entity(entity, type_id, source->mask, archetype->mask);
+        column = archetype->get_column(type_id);
+    }
+    archetype->set_component(entity->archetype_row, column, component);
+    _index_component(entity, type_id, component);
+    _mark_added(component);
+}
+
+void World::_erase_entity_component(Entity *entity, int type_id) {
+    Archetype *source = entity->archetype;
+    if (!source->has_type(type_id)) return;
+    Archetype *target = _archetype_without(source, type_id);
+    _unindex_component(entity, type_id);
+    _move_entity(entity, target);
+    _cache_update_entity(entity, type_id, source->mask, target->mask);
+}
+
+void World::_apply_component_changes(Entity *entity, const LocalVector<int> &p_added_types, const LocalVector<Ref<Component>> &p_added, const LocalVector<int> &p_removed_types) {
+    Archetype *source = entity->archetype;
+    ComponentMask mask = source->mask;
+    int changed_type = -1;
+    uint32_t changed_count = 0;
+    for (uint32_t i = 0; i < p_removed_types.size(); ++i) {
+        mask.unset(p_removed_types[i]);
+        _unindex_component(entity, p_removed_types[i]);
+        changed_type = p_removed_types[i];
+        changed_count++;
+    }
+    for (uint32_t i = 0; i < p_added_types.size(); ++i) {
+        if (!source->has_type(p_added_types[i])) {
+            mask.set(p_added_types[i]);
+            changed_type = p_added_types[i];
+            changed_count++;
+        }
+    }
+
+    Archetype *target = source;
+    if (changed_count > 0) {
+        Archetype **existing = archetypes.getptr(mask);
+        if (existing) {
+            target = *existing;
         } else {
-            result = any_result;
+            LocalVector<int> types;
+            mask.get_ids(types);
+            target = _get_or_create_archetype(types);
+        }
+        _move_entity(entity, target);
+        InvalidationCause cause = p_added_types.is_empty() ? INVALIDATION_COMPONENT_REMOVED : INVALIDATION_COMPONENT_ADDED;
+        if (_batching_moves) {
+            PendingMove move;
+            move.entity = entity;
+            move.source = source;
+            move.target = target;
+            move.cause = cause;
+            _pending_moves.push_back(move);
+        } else if (changed_count == 1) {
+            _cache_update_entity(entity, changed_type, source->mask, target->mask);
+        } else {
+            // One pass over the cache for the whole batch instead of one per type.
+            for (uint32_t i = 0; i < _cached_queries.size(); ++i) {
+                CachedQuery *query = _cached_queries[i];
+                bool was_match = query->key.matches(source->mask);
+                bool is_match = query->key.matches(target->mask);
+                if (is_match && !was_match) {
+                    _cache_insert(query, entity, cause);
+                } else if (was_match && !is_match) {
+                    _cache_erase(query, entity, cause);
+                }
+            }
         }
     }
-    
-    if (!has_all_filter && any_comps.is_empty()) {
-        result = entities.values();
+
+    for (uint32_t i = 0; i < p_added.size(); ++i) {
+        target->set_component(entity->archetype_row, target->get_column(p_added_types[i]), p_added[i]);
+        _index_component(entity, p_added_types[i], p_added[i]);
+        _mark_added(p_added[i]);
     }
-    
-    if (!none_comps.is_empty()) {
-        for (int i = 0; i < none_comps.size(); ++i) {
-            Ref<Script> script = none_comps[i];
-            if (script.is_null()) continue;
-            String path = script->get_path();
-            if (component_entity_index.has(path)) {
-                result = GECS::difference(result, component_entity_index[path]);
+}
+
+void World::_mark_added(const Ref<Component> &component) {
+    // Shared components have one tick for every entity holding them, so they aren't tracked.
+    if (component.is_valid() && !component->is_shared()) {
+        component->_mark_added(_get_change_tick());
+    }
+}
+
+void World::_begin_move_batch() {
+    _batching_moves = true;
+}
+
+void World::_end_move_batch() {
+    _batching_moves = false;
+    if (_pending_moves.is_empty()) return;
+
+    // Entities making the same move flip the same queries: match each query once per distinct move.
+    LocalVector<Archetype *> sources;
+    LocalVector<Archetype *> targets;
+    LocalVector<uint32_t> move_kinds;
+    move_kinds.resize(_pending_moves.size());
+    for (uint32_t i = 0; i < _pending_moves.size(); ++i) {
+        uint32_t kind = 0;
+        while (kind < sources.size() && (sources[kind] != _pending_moves[i].source || targets[kind] != _pending_moves[i].target)) {
+            kind++;
+        }
+        if (kind == sources.size()) {
+            sources.push_back(_pending_moves[i].source);
+            targets.push_back(_pending_moves[i].target);
+        }
+        move_kinds[i] = kind;
+    }
+
+    // Per move kind: 1 when the query starts matching, -1 when it stops, 0 otherwise.
+    LocalVector<int8_t> flips;
+    flips.resize(sources.size());
+    for (uint32_t q = 0; q < _cached_queries.size(); ++q) {
+        CachedQuery *query = _cached_queries[q];
+        bool any = false;
+        for (uint32_t k = 0; k < sources.size(); ++k) {
+            bool was_match = query->key.matches(sources[k]->mask);
+            bool is_match = query->key.matches(targets[k]->mask);
+            flips[k] = is_match == was_match ? 0 : (is_match ? 1 : -1);
+            any = any || flips[k] != 0;
+        }
+        if (!any) continue;
+        for (uint32_t i = 0; i < _pending_moves.size(); ++i) {
+            const PendingMove &move = _pending_moves[i];
+            if (flips[move_kinds[i]] > 0) {
+                _cache_insert(query, move.entity, move.cause);
+            } else if (flips[move_kinds[i]] < 0) {
+                _cache_erase(query, move.entity, move.cause);
             }
         }
     }
+    _pending_moves.clear();
+}
 
-    _query_result_cache[cache_key] = result;
-    return result;
+void World::_index_component(Entity *entity, int type_id, const Ref<Component> &component) {
+    if (uint32_t(type_id) >= _property_indexes_by_type.size() || component.is_null()) return;
+    const LocalVector<PropertyIndex *> &indexes = _property_indexes_by_type[type_id];
+    for (uint32_t i = 0; i < indexes.size(); ++i) {
+        indexes[i]->set(entity, component->get(indexes[i]->property));
+    }
 }
 
-void World::_add_entity_to_index(Entity *entity, const String &component_path) {
-    if (!component_entity_index.has(component_path)) {
-        component_entity_index[component_path] = Array();
+void World::_unindex_component(Entity *entity, int type_id) {
+    if (uint32_t(type_id) >= _property_indexes_by_type.size()) return;
+    const LocalVector<PropertyIndex *> &indexes = _property_indexes_by_type[type_id];
+    for (uint32_t i = 0; i < indexes.size(); ++i) {
+        indexes[i]->erase(entity);
     }
-    Array list = component_entity_index[component_path];
-    if (!list.has(entity)) {
-        list.push_back(entity);
-        component_entity_index[component_path] = list;
+}
+
+void World::create_property_index(const Ref<Resource> &p_component, const StringName &p_property) {
+    int type_id = GECS::get_component_type_id(p_component);
+    if (type_id < 0) {
+        UtilityFunctions::push_error("create_property_index expects a component script");
+        return;
+    }
+    PropertyKey key;
+    key.type_id = type_id;
+    key.property = p_property;
+    if (_property_indexes.has(key)) return;
+
+    PropertyIndex *index = memnew(PropertyIndex(type_id, p_property));
+    if (uint32_t(type_id) < component_archetype_index.size()) {
+        const LocalVector<Archetype *> &with_comp = component_archetype_index[type_id];
+        for (uint32_t a = 0; a < with_comp.size(); ++a) {
+            Archetype *archetype = with_comp[a];
+            const LocalVector<Ref<Component>> &column = archetype->columns[archetype->get_column(type_id)];
+            for (uint32_t row = 0; row < archetype->entities.size(); ++row) {
+                index->set(archetype->entities[row], column[row]->get(p_property));
+            }
+        }
+    }
+
+    // Published and versioned together, under the lock value changes take.
+    std::lock_guard<std::mutex> lock(_sync_mutex);
+    _property_indexes.insert(key, index);
+    if (uint32_t(type_id) >= _property_indexes_by_type.size()) {
+        _property_indexes_by_type.resize(type_id + 1);
+    }
+    _property_indexes_by_type[type_id].push_back(index);
+    // Builders that already cached a value query should pick up the index.
+    _property_versions[key] = ++_query_version;
+}
+
+void World::remove_property_index(const Ref<Resource> &p_component, const StringName &p_property) {
+    PropertyKey key;
+    key.type_id = GECS::get_component_type_id(p_component);
+    key.property = p_property;
+    std::lock_guard<std::mutex> lock(_sync_mutex);
+    PropertyIndex **index = _property_indexes.getptr(key);
+    if (!index) return;
+
+    _property_indexes_by_type[key.type_id].erase(*index);
+    memdelete(*index);
+    _property_indexes.erase(key);
+}
+
+bool World::has_property_index(const Ref<Resource> &p_component, const StringName &p_property) const {
+    PropertyKey key;
+    key.type_id = GECS::get_component_type_id(p_component);
+    key.property = p_property;
+    std::lock_guard<std::mutex> lock(_sync_mutex);
+    return _property_indexes.has(key);
+}
+
+Array World::get_entities() {
+    std::lock_guard<std::mutex> lock(_sync_mutex);
+    if (entity_list_dirty) {
+        // Callers may still hold the previous snapshot, so never write into it.
+        const LocalVector<Entity *> &dense = entities.get_entities();
+        entity_list = Array();
+        entity_list.resize(dense.size());
+        for (uint32_t i = 0; i < dense.size(); ++i) {
+            entity_list[i] = dense[i];
+        }
+        entity_list_dirty = false;
+    }
+    return entity_list;
+}
+
+int World::get_entity_count() const {
+    return entities.size();
+}
+
+bool World::has_entity(Entity *entity) const {
+    return entity && entity->world == this && entities.get(entity->handle) == entity;
+}
+
+Entity *World::get_entity(int64_t p_handle) const {
+    return entities.get(uint64_t(p_handle));
+}
+
+bool World::is_entity_handle_valid(int64_t p_handle) const {
+    return entities.is_valid(uint64_t(p_handle));
+}
+
+// Reads under the sync lock because worker-thread queries race value changes on the main thread.
+bool World::_collect_property_index(const PropertyKey &p_key, const LocalVector<ComponentPredicate::Test> &p_tests, LocalVector<Entity *> &r_entities, uint32_t &r_index_size) const {
+    std::lock_guard<std::mutex> lock(_sync_mutex);
+    PropertyIndex *const *index = _property_indexes.getptr(p_key);
+    if (!index || !(*index)->collect(p_tests, r_entities)) return false;
+    r_index_size = (*index)->size();
+    return true;
+}
+
+void World::_clear_property_indexes() {
+    std::lock_guard<std::mutex> lock(_sync_mutex);
+    for (const KeyValue<PropertyKey, PropertyIndex *> &E : _property_indexes) {
+        memdelete(E.value);
     }
+    _property_indexes.clear();
+    _property_indexes_by_type.clear();
 }
 
-void World::_remove_entity_from_index(Entity *entity, const String &component_path) {
-    if (component_entity_index.has(component_path)) {
-        Array list = component_entity_index[component_path];
-        list.erase(entity);
-        component_entity_index[component_path] = list;
+void World::_clear_storage() {
+    _clear_query_cache();
+    _clear_property_indexes();
+    _relationship_index.clear();
+    _relationship_version++;
+    for (uint32_t a = 0; a < archetype_list.size(); ++a) {
+        Archetype *archetype = archetype_list[a];
+        for (uint32_t row = 0; row < archetype->entities.size(); ++row) {
+            _restore_detached_components(archetype->entities[row]);
+        }
+        memdelete(archetype);
     }
+    archetype_list.clear();
+    archetypes.clear();
+    component_archetype_index.clear();
+    entities.clear();
+    entity_list = Array();
+    entity_list_dirty = true;
 }
 
 void World::_on_entity_component_added(Object *entity_obj, Object *component_obj) {
     Entity* entity = Object::cast_to<Entity>(entity_obj);
     Component* component = Object::cast_to<Component>(component_obj);
     if (!entity || !component) return;
-    
+    _emit_cache_invalidated();
+
     Ref<Script> script = component->get_script();
     if (script.is_null()) return;
 
-    _add_entity_to_index(entity, script->get_path());
     emit_signal("component_added", entity, component);
+    if (!_is_type_observed(component->get_type_id())) return;
 
-    Dictionary event;
-    event["type"] = "component_added";
-    event["entity"] = entity;
-    event["component"] = component;
-    _observer_queue.push_back(event);
-
-    _query_result_cache.clear();
-    emit_signal("cache_invalidated");
+    std::lock_guard<std::mutex> lock(_sync_mutex);
+    _observer_queue.push(ObserverEventQueue::COMPONENT_ADDED, entity->get_instance_id(), component);
 }
 
 void World::_on_entity_component_removed(Object *entity_obj, Object *component_obj) {
     Entity* entity = Object::cast_to<Entity>(entity_obj);
     Component* component = Object::cast_to<Component>(component_obj);
     if (!entity || !component) return;
+    _emit_cache_invalidated();
     
     Ref<Script> script = component->get_script();
     if (script.is_null()) return;
     
-    _remove_entity_from_index(entity, script->get_path());
     emit_signal("component_removed", entity, component);
+    if (!_is_type_observed(component->get_type_id())) return;
 
-    Dictionary event;
-    event["type"] = "component_removed";
-    event["entity"] = entity;
-    event["component"] = component;
-    _observer_queue.push_back(event);
-
-    _query_result_cache.clear();
-    emit_signal("cache_invalidated");
+    std::lock_guard<std::mutex> lock(_sync_mutex);
+    _observer_queue.push(ObserverEventQueue::COMPONENT_REMOVED, entity->get_instance_id(), component);
 }
 
 void World::_on_entity_component_property_changed(Object *entity_obj, Object *component_obj, const StringName &property, const Variant &old_value, const Variant &new_value) {
@@ -541,62 +1421,111 @@ void World::_on_entity_component_property_changed(Object *entity_obj, Object *co
     if (!entity || !component) return;
 
     emit_signal("component_changed", entity, component, property, new_value, old_value);
+    if (!_is_type_observed(component->get_type_id())) return;
 
-    Dictionary event;
-    event["type"] = "component_changed";
-    event["entity"] = entity;
-    event["component"] = component;
-    event["property"] = property;
-    event["new_value"] = new_value;
-    event["old_value"] = old_value;
-    _observer_queue.push_back(event);
-    
-    _query_result_cache.clear();
-    emit_signal("cache_invalidated");
+    std::lock_guard<std::mutex> lock(_sync_mutex);
+    _observer_queue.push_changed(entity->get_instance_id(), component, property, old_value, new_value);
 }
 
-void World::_handle_observer_component_added(Entity *entity, Component *component) {
-    for (int i = 0; i < observers.size(); i++) {
-        Observer *observer = Object::cast_to<Observer>(observers[i]);
-        if (!observer) continue;
+void World::_remove_relationships_to(Entity *entity) {
+    const LocalVector<RelationshipIndex::Reference> *pointing = _relationship_index.get_referencing(entity->get_instance_id());
+    if (!pointing) return;
+    // Each removal edits the index list, so work from a copy. The source comes
+    // from the index: a relationship shared by several entities only remembers the last.
+    LocalVector<uint64_t> sources;
+    LocalVector<Ref<Relationship>> relationships;
+    for (uint32_t i = 0; i < pointing->size(); i++) {
+        sources.push_back((*pointing)[i].source);
+        relationships.push_back(Ref<Relationship>((*pointing)[i].relationship));
+    }
+    for (uint32_t i = 0; i < relationships.size(); i++) {
+        Entity *source = Object::cast_to<Entity>(ObjectDB::get_instance(sources[i]));
+        if (source) {
+            source->_remove_relationship_instance(relationships[i]);
+        }
+    }
+}
 
-        Ref<Resource> watch_script = observer->watch();
+void World::_on_entity_relationship_added(Object *entity_obj, Object *relationship_obj) {
+    Entity *entity = Object::cast_to<Entity>(entity_obj);
+    Ref<Relationship> relationship = Object::cast_to<Relationship>(relationship_obj);
+    if (!entity || relationship.is_null() || entity->world != this) return;
+    if (SystemScheduler::is_worker_thread()) {
+        SystemScheduler::defer_call(callable_mp(this, &World::_on_entity_relationship_added).bind(entity_obj, relationship_obj));
+        return;
+    }
+    _relationship_index.add(entity, relationship);
+    _relationship_version++;
+    emit_signal("relationship_added", entity, relationship);
+}
 
-        Ref<Script> comp_script = component->get_script();
-        if (watch_script.is_valid() && comp_script.is_valid() && watch_script->get_path() == comp_script->get_path()) {
-            Ref<QueryBuilder> qb = observer->match();
-            if (qb.is_valid() && qb->execute().has(entity)) {
-                observer->on_component_added(entity, component);
-            }
+void World::_on_entity_relationship_removed(Object *entity_obj, Object *relationship_obj) {
+    Entity *entity = Object::cast_to<Entity>(entity_obj);
+    Ref<Relationship> relationship = Object::cast_to<Relationship>(relationship_obj);
+    if (!entity || relationship.is_null() || entity->world != this) return;
+    if (SystemScheduler::is_worker_thread()) {
+        SystemScheduler::defer_call(callable_mp(this, &World::_on_entity_relationship_removed).bind(entity_obj, relationship_obj));
+        return;
+    }
+    _relationship_index.remove(entity, relationship);
+    _relationship_version++;
+    emit_signal("relationship_removed", entity, relationship);
+}
+
+void World::_on_component_value_changed(Entity *entity, Component *component, const StringName &property, const Variant &new_value) {
+    if (!component) return;
+
+    std::lock_guard<std::mutex> lock(_sync_mutex);
+    PropertyKey key;
+    key.type_id = component->get_type_id();
+    key.property = property;
+    PropertyIndex **index = _property_indexes.getptr(key);
+    if (index) {
+        (*index)->set(entity, new_value);
+    }
+
+    // Presence-based results cannot change here; only value queries watching this property are stale.
+    uint64_t *version = _property_versions.getptr(key);
+    if (version) {
+        *version = ++_query_version;
+        _invalidations[INVALIDATION_PROPERTY_CHANGED]++;
+    }
+}
+
+bool World::_is_type_observed(int type_id) const {
+    return type_id >= 0 && (uint32_t)type_id < observer_type_index.size() && !observer_type_index[type_id].is_empty();
+}
+
+void World::_handle_observer_component_added(Entity *entity, Component *component) {
+    if (!_is_type_observed(component->get_type_id())) return;
+    // Callbacks may add or remove observers, so iterate a copy.
+    LocalVector<uint64_t> watchers = observer_type_index[component->get_type_id()];
+    for (uint32_t i = 0; i < watchers.size(); i++) {
+        Observer *observer = Object::cast_to<Observer>(ObjectDB::get_instance(watchers[i]));
+        if (observer && observer->_matches(entity)) {
+            observer->on_component_added(entity, component);
         }
     }
 }
 
 void World::_handle_observer_component_removed(Entity *entity, Component *component) {
-    for (int i = 0; i < observers.size(); i++) {
-        Observer *observer = Object::cast_to<Observer>(observers[i]);
-        if (!observer) continue;
-
-        Ref<Resource> watch_script = observer->watch();
-        Ref<Script> comp_script = component->get_script();
-        if (watch_script.is_valid() && comp_script.is_valid() && watch_script->get_path() == comp_script->get_path()) {
+    if (!_is_type_observed(component->get_type_id())) return;
+    LocalVector<uint64_t> watchers = observer_type_index[component->get_type_id()];
+    for (uint32_t i = 0; i < watchers.size(); i++) {
+        Observer *observer = Object::cast_to<Observer>(ObjectDB::get_instance(watchers[i]));
+        if (observer) {
             observer->on_component_removed(entity, component);
         }
     }
 }
 
 void World::_handle_observer_component_changed(Entity *entity, Component *component, const StringName &property, const Variant &new_value, const Variant &old_value) {
-    for (int i = 0; i < observers.size(); i++) {
-        Observer *observer = Object::cast_to<Observer>(observers[i]);
-        if (!observer) continue;
-
-        Ref<Resource> watch_script = observer->watch();
-        Ref<Script> comp_script = component->get_script();
-        if (watch_script.is_valid() && comp_script.is_valid() && watch_script->get_path() == comp_script->get_path()) {
-            Ref<QueryBuilder> qb = observer->match();
-            if (qb.is_valid() && qb->execute().has(entity)) {
-                observer->on_component_changed(entity, component, property, new_value, old_value);
-            }
+    if (!_is_type_observed(component->get_type_id())) return;
+    LocalVector<uint64_t> watchers = observer_type_index[component->get_type_id()];
+    for (uint32_t i = 0; i < watchers.size(); i++) {
+        Observer *observer = Object::cast_to<Observer>(ObjectDB::get_instance(watchers[i]));
+        if (observer && observer->_matches(entity)) {
+            observer->on_component_changed(entity, component, property, new_value, old_value);
         }
     }
 }
@@ -629,6 +1558,13 @@ Dictionary World::get_cache_stats() const {
     stats["cache_misses"] = _cache_misses;
     stats["hit_rate"] = hit_rate;
     stats["cached_queries"] = (int)_query_result_cache.size();
+    stats["archetypes"] = (int)archetype_list.size();
+
+    Dictionary invalidations;
+    for (int i = 0; i < INVALIDATION_MAX; i++) {
+        invalidations[invalidation_names[i]] = _invalidations[i];
+    }
+    stats["invalidations"] = invalidations;
     
     return stats;
 }
@@ -636,4 +1572,7 @@ Dictionary World::get_cache_stats() const {
 void World::reset_cache_stats() {
     _cache_hits = 0;
     _cache_misses = 0;
+    for (int i = 0; i < INVALIDATION_MAX; i++) {
+        _invalidations[i] = 0;
+    }
 }
\ No newline at end of file
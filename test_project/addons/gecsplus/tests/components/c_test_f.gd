@@ -0,0 +1,7 @@
+extends Component
+
+@export var value: int = 0
+
+
+func _init():
+	value = 3
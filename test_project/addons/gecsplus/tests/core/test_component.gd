@@ -45,3 +45,14 @@ func test_component_serialization():
 	# Check if the serialized data matches the expected values
 	assert_int(serialized_data_a["value"]).is_equal(42)
 	assert_int(serialized_data_b["points"]).is_equal(1)
+
+
+func test_component_type_ids_are_stable_and_dense():
+	var id_a = GECS.get_component_type_id(C_TestA)
+	var id_b = GECS.get_component_type_id(C_TestB)
+	# Instances resolve to the same ID as their script
+	assert_int(GECS.get_component_type_id(C_TestA.new())).is_equal(id_a)
+	assert_int(GECS.get_component_type_id(C_TestA)).is_equal(id_a)
+	assert_int(id_b).is_not_equal(id_a)
+	assert_int(GECS.get_component_type_count()).is_greater(max(id_a, id_b))
+	assert_str(GECS.get_component_type_path(id_a)).is_equal(C_TestA.resource_path)
@@ -83,3 +83,19 @@ func test_add_get_has_relationship():
 	assert_str(type_string(typeof(class_retrieved_relationship))).is_equal(
 		type_string(typeof(Relationship.new(C_TestA.new(), entitya)))
 	)
+
+
+func test_saved_component_resources_pick_up_runtime_edits():
+	var resource = C_TestC.new(5)
+	resource.resource_path = "res://addons/gecs/tests/components/c_test_c_runtime.tres"
+	var first = Entity.new()
+	first.component_resources = [resource]
+	world.add_entity(first)
+	assert_int(first.get_component(C_TestC).value).is_equal(5)
+
+	resource.value = 6
+	resource.emit_changed()
+	var second = Entity.new()
+	second.component_resources = [resource]
+	world.add_entity(second)
+	assert_int(second.get_component(C_TestC).value).is_equal(6)
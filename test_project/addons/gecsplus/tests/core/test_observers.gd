@@ -0,0 +1,85 @@
+extends GdUnitTestSuite
+
+var runner: GdUnitSceneRunner
+var world: World
+
+const C_TestA = preload("res://addons/gecs/tests/components/c_test_a.gd")
+const C_TestB = preload("res://addons/gecs/tests/components/c_test_b.gd")
+const C_TestC = preload("res://addons/gecs/tests/components/c_test_c.gd")
+
+
+class CountingObserver:
+	extends Observer
+	var watched: Script
+	var excluded: Array
+	var added := []
+
+	func watch() -> Resource:
+		return watched
+
+	func match() -> QueryBuilder:
+		return q.with_none(excluded)
+
+	func on_component_added(entity: Entity, component: Resource) -> void:
+		added.append(entity)
+
+
+class ChangeObserver:
+	extends Observer
+	var changes := []
+
+	func watch() -> Resource:
+		return C_TestC
+
+	func on_component_changed(entity: Entity, component: Resource, property: String, new_value: Variant, old_value: Variant) -> void:
+		changes.append([old_value, new_value])
+
+
+func before():
+	runner = scene_runner("res://addons/gecs/tests/test_scene.tscn")
+	world = runner.get_property("world")
+	ECS.world = world
+
+
+func after_test():
+	if world:
+		world.purge(false)
+
+
+func test_observers_only_see_their_watched_type_and_match():
+	var observer_a = CountingObserver.new()
+	observer_a.watched = C_TestA
+	observer_a.excluded = [C_TestB]
+	var observer_c = CountingObserver.new()
+	observer_c.watched = C_TestC
+	world.add_observers([observer_a, observer_c])
+
+	var plain = Entity.new()
+	var excluded = Entity.new()
+	world.add_entities([plain, excluded])
+	plain.add_component(C_TestA.new())
+	excluded.add_component(C_TestB.new())
+	excluded.add_component(C_TestA.new())
+	world.process(0.1)
+
+	assert_array(observer_a.added).contains_exactly([plain])
+	assert_array(observer_c.added).is_empty()
+
+
+func test_coalesced_changes_keep_first_old_and_last_new_value():
+	var observer = ChangeObserver.new()
+	world.add_observer(observer)
+	world.observer_coalescing = true
+
+	var entity = Entity.new()
+	world.add_entity(entity)
+	var component = C_TestC.new(0)
+	entity.add_component(component)
+	for value in [1, 2, 3]:
+		var old_value = component.value
+		component.value = value
+		component.emit_property_changed("value", old_value, value)
+	world.process(0.1)
+
+	assert_array(observer.changes).is_equal([[0, 3]])
+	world.observer_coalescing = false
@@ -0,0 +1,52 @@
+extends GdUnitTestSuite
+
+const C_TestB = preload("res://addons/gecs/tests/components/c_test_b.gd")
+const C_TestC = preload("res://addons/gecs/tests/components/c_test_c.gd")
+const C_TestF = preload("res://addons/gecs/tests/components/c_test_f.gd")
+
+var runner: GdUnitSceneRunner
+var world: World
+
+
+func before():
+	runner = scene_runner("res://addons/gecs/tests/test_scene.tscn")
+	world = runner.get_property("world")
+	ECS.world = world
+
+
+func after_test():
+	world.purge(false)
+
+
+func test_prefab_copies_and_shares_components():
+	var prefab = Prefab.new()
+	prefab.add_component(C_TestC.new(5))
+	prefab.add_component(C_TestB.new(), true)
+
+	var entities = world.spawn_batch(prefab, 3)
+	assert_int(entities.size()).is_equal(3)
+
+	# Copied components start from the template values and are independent
+	entities[0].get_component(C_TestC).value = 9
+	assert_int(entities[1].get_component(C_TestC).value).is_equal(5)
+
+	# Shared components are one object until an entity asks to write
+	var shared = entities[0].get_component(C_TestB)
+	assert_bool(shared.is_shared()).is_true()
+	assert_object(entities[1].get_component(C_TestB)).is_same(shared)
+	var own = entities[0].get_component_mut(C_TestB)
+	assert_object(own).is_not_same(shared)
+	assert_object(entities[0].get_component(C_TestB)).is_same(own)
+	assert_object(entities[1].get_component(C_TestB)).is_same(shared)
+
+
+func test_prefab_keeps_values_the_constructor_overwrites():
+	# C_TestF declares 0 but its _init() assigns 3; the prefab asks for 0 again
+	var component = C_TestF.new()
+	component.value = 0
+	var prefab = Prefab.new()
+	prefab.add_component(component)
+
+	var entities = world.spawn_batch(prefab, 2)
+	for entity in entities:
+		assert_int(entity.get_component(C_TestF).value).is_equal(0)
@@ -898,3 +898,145 @@ func test_query_cache_with_component_queries():
 	var result3 = query.execute()
 	assert_bool(result3.has(target_entity)).is_false()
 	assert_int(result3.size()).is_equal(result2.size() - 1)
+
+
+func test_query_cache_updates_incrementally():
+	var entity1 = Entity.new()
+	var entity2 = Entity.new()
+	entity1.add_component(C_TestA.new())
+	entity2.add_component(C_TestB.new())
+	world.add_entities([entity1, entity2])
+	world.reset_cache_stats()
+
+	var query = QueryBuilder.new(world).with_all([C_TestA])
+	var before = query.execute()
+	assert_array(before).has_size(1)
+
+	# Structural changes update the cached result without an explicit invalidate_cache()
+	entity2.add_component(C_TestA.new())
+	var after_add = query.execute()
+	assert_array(after_add).has_size(2)
+	assert_bool(after_add.has(entity2)).is_true()
+	# Previously returned results are snapshots and stay untouched
+	assert_array(before).has_size(1)
+
+	entity1.remove_component(C_TestA)
+	var after_remove = query.execute()
+	assert_array(after_remove).has_size(1)
+	assert_bool(after_remove.has(entity1)).is_false()
+
+	# Unrelated changes keep serving the same cached result
+	entity1.add_component(C_TestC.new())
+	assert_array(query.execute()).is_equal(after_remove)
+
+	var stats = world.get_cache_stats()
+	assert_int(stats["cache_misses"]).is_equal(1)
+	assert_int(stats["cache_hits"]).is_equal(3)
+
+
+func test_property_changes_keep_structural_cache():
+	var entity = Entity.new()
+	var comp = C_TestC.new(1)
+	entity.add_component(comp)
+	world.add_entity(entity)
+	world.reset_cache_stats()
+
+	var query = QueryBuilder.new(world).with_all([C_TestC])
+	var result1 = query.execute()
+
+	comp.value = 2
+	comp.emit_property_changed("value", 1, 2)
+	var result2 = query.execute()
+
+	assert_array(result2).is_equal(result1)
+	var stats = world.get_cache_stats()
+	assert_int(stats["cache_misses"]).is_equal(1)
+	assert_int(stats["invalidations"]["property_changed"]).is_equal(0)
+
+
+func test_query_with_property_index():
+	var entities = []
+	for i in range(10):
+		var entity = Entity.new()
+		entity.add_component(C_TestC.new(i))
+		world.add_entity(entity)
+		entities.append(entity)
+	world.create_property_index(C_TestC, "value")
+	assert_bool(world.has_property_index(C_TestC, "value")).is_true()
+
+	var query = QueryBuilder.new(world).with_all([{C_TestC: {"value": {"_gte": 3, "_lt": 6}}}])
+	var result = query.execute()
+	assert_array(result).has_size(3)
+	assert_bool(result.has(entities[3])).is_true()
+	assert_bool(result.has(entities[5])).is_true()
+
+	# The index follows property_changed notifications
+	var comp = entities[9].get_component(C_TestC)
+	comp.value = 4
+	comp.emit_property_changed("value", 9, 4)
+	result = query.execute()
+	assert_array(result).has_size(4)
+	assert_bool(result.has(entities[9])).is_true()
+
+	assert_array(QueryBuilder.new(world).with_all([{C_TestC: {"value": {"_in": [0, 4, 42]}}}]).execute()).has_size(3)
+
+	world.remove_property_index(C_TestC, "value")
+	assert_bool(world.has_property_index(C_TestC, "value")).is_false()
+
+
+func test_compile_query_string():
+	var entity1 = Entity.new()
+	var entity2 = Entity.new()
+	var entity3 = Entity.new()
+	entity1.add_component(C_TestA.new())
+	entity1.add_component(C_TestC.new(30))
+	entity2.add_component(C_TestA.new())
+	entity2.add_component(C_TestC.new(5))
+	entity3.add_component(C_TestA.new())
+	entity3.add_component(C_TestB.new())
+	entity1.add_to_group("Enemy")
+	world.add_entities([entity1, entity2, entity3])
+
+	var text = (
+		'with_all("res://addons/gecs/tests/components/c_test_a.gd")'
+		+ ' with_none("res://addons/gecs/tests/components/c_test_b.gd")'
+		+ ' with_any("res://addons/gecs/tests/components/c_test_c.gd"{value >= 10, value in [30, 40]})'
+	)
+	var query = QueryBuilder.new(world)
+	var result = query.compile(text).execute()
+	assert_array(result).has_size(1)
+	assert_bool(result.has(entity1)).is_true()
+
+	# Recompiling the same string keeps the builder's cached result
+	assert_array(query.compile(text).execute()).is_equal(result)
+
+	result = QueryBuilder.new(world).compile("group(Enemy)").execute()
+	assert_array(result).has_size(1)
+	assert_bool(result.has(entity1)).is_true()
+
+	# An invalid query string leaves the builder matching nothing until it is cleared
+	var invalid = QueryBuilder.new(world).compile("with_all(")
+	assert_array(invalid.execute()).is_empty()
+	assert_array(invalid.matches(world.entities)).is_empty()
+	assert_array(invalid.clear().execute()).has_size(world.entities.size())
+
+
+func test_query_explain():
+	var boss = null
+	for i in range(20):
+		var entity = Entity.new()
+		entity.add_component(C_TestC.new(i))
+		if i == 7:
+			entity.add_to_group("Boss")
+			boss = entity
+		world.add_entity(entity)
+
+	var query = QueryBuilder.new(world).with_all([{C_TestC: {"value": {"_gt": 5}}}]).with_group(["Boss"])
+	var plan = query.explain()
+	# The single-member group is a smaller starting set than every C_TestC holder
+	assert_str(plan["source"]).is_equal("groups")
+	assert_int(plan["source_size"]).is_equal(1)
+	assert_int(plan["result"]).is_equal(1)
+	for stage in plan["stages"]:
+		assert_int(stage["output"]).is_less_equal(stage["input"])
+	assert_array(query.execute()).contains_exactly([boss])
@@ -195,20 +195,59 @@ func test_weak_relationship_matching():
 	assert_bool(bob_doesnt_eat_apples == null).is_true()  # bob doesn't eat apples
 	assert_bool(bob_has_eats_apples).is_false()  # bob doesn't eat apples
 
-# # FIXME: This is not working
-# func test_reverse_relationships_a():
-
-# 	# Here I want to get the reverse of this relationship I want to get all the food being attacked.
-# 	var food_being_attacked = ECS.world.query.with_reverse_relationship([Relationship.new(C_IsAttacking.new(), ECS.wildcard)]).execute()
-# 	assert_bool(food_being_attacked.has(e_apple)).is_true() # The Apple is being attacked by alice because she's attacking all food
-# 	assert_bool(food_being_attacked.has(e_pizza)).is_true() # The pizza is being attacked by alice because she's attacking all food
-# 	assert_bool(Array(food_being_attacked).size() == 2).is_true() # pizza and apples are UNDER ATTACK
-
-# # FIXME: This is not working
-# func test_reverse_relationships_b():
-# 	# Query 2: Find all entities that are the target of any relationship with Person archetype
-# 	var entities_with_relations_to_people = ECS.world.query.with_reverse_relationship([Relationship.new(ECS.wildcard, Person)]).execute()
-# 	# This returns any entity that is the TARGET of any relationship where Person is specified
-# 	assert_bool(Array(entities_with_relations_to_people).has(e_heather)).is_true() # heather is loved by alice
-# 	assert_bool(Array(entities_with_relations_to_people).has(e_alice)).is_true() # alice is liked by bob
-# 	assert_bool(Array(entities_with_relations_to_people).size() == 2).is_true() # only two people are the targets of relations with other persons
+func test_reverse_relationships_a():
+
+	# Here I want to get the reverse of this relationship I want to get all the food being attacked.
+	var food_being_attacked = ECS.world.query.with_reverse_relationship([Relationship.new(C_IsAttacking.new(), ECS.wildcard)]).execute()
+	assert_bool(food_being_attacked.has(e_apple)).is_true() # The Apple is being attacked by alice because she's attacking all food
+	assert_bool(food_being_attacked.has(e_pizza)).is_true() # The pizza is being attacked by alice because she's attacking all food
+	assert_bool(Array(food_being_attacked).size() == 2).is_true() # pizza and apples are UNDER ATTACK
+
+func test_reverse_relationships_b():
+	# Query 2: Find all entities that are the target of any relationship with Person archetype
+	var entities_with_relations_to_people = ECS.world.query.with_reverse_relationship([Relationship.new(ECS.wildcard, Person)]).execute()
+	# This returns any entity that is the TARGET of any relationship where Person is specified
+	assert_bool(Array(entities_with_relations_to_people).has(e_heather)).is_true() # heather is loved by alice
+	assert_bool(Array(entities_with_relations_to_people).has(e_alice)).is_true() # alice is liked by bob
+	# bob cries in front of the Person script, which targets every Person, bob himself included
+	assert_bool(Array(entities_with_relations_to_people).has(e_bob)).is_true()
+	assert_int(Array(entities_with_relations_to_people).size()).is_equal(3)
+
+
+func test_relationship_queries_follow_index_updates():
+	var query = world.query.with_relationship([Relationship.new(C_Likes.new(), e_alice)])
+	assert_array(query.execute()).contains_exactly([e_bob])
+
+	e_heather.add_relationship(Relationship.new(C_Likes.new(), e_alice))
+	assert_array(query.execute()).contains_exactly_in_any_order([e_bob, e_heather])
+
+	e_bob.remove_relationship(Relationship.new(C_Likes.new(), e_alice))
+	assert_array(query.execute()).contains_exactly([e_heather])
+
+
+func test_reverse_relationships_combine_with_components():
+	e_apple.add_component(C_Loves.new())
+	var attacked_and_loved = ECS.world.query.with_all([C_Loves]).with_reverse_relationship([Relationship.new(C_IsAttacking.new())]).execute()
+	assert_array(attacked_and_loved).contains_exactly([e_apple])
+
+	var liked_by_someone = ECS.world.query.with_reverse_relationship([Relationship.new(C_Likes.new(), e_alice)]).execute()
+	assert_array(liked_by_someone).contains_exactly([e_alice])
+
+
+func test_removing_target_removes_relationships_to_it():
+	world.remove_entity(e_alice)
+
+	assert_bool(e_bob.has_relationship(Relationship.new(C_Likes.new(), e_alice))).is_false()
+	assert_bool(e_bob.has_relationship(Relationship.new(C_Likes.new(), e_pizza))).is_true()
+	assert_array(world.query.with_relationship([Relationship.new(C_Likes.new(), e_alice)]).execute()).is_empty()
+
+
+func test_removing_target_removes_a_relationship_shared_by_two_sources():
+	var loves_pizza = Relationship.new(C_Loves.new(), e_pizza)
+	e_bob.add_relationship(loves_pizza)
+	e_heather.add_relationship(loves_pizza)
+
+	world.remove_entity(e_pizza)
+
+	assert_bool(e_bob.has_relationship(Relationship.new(C_Loves.new(), e_pizza))).is_false()
+	assert_bool(e_heather.has_relationship(Relationship.new(C_Loves.new(), e_pizza))).is_false()
@@ -18,6 +18,103 @@ var runner: GdUnitSceneRunner
 var world: World
 
 
+class BatchSystem:
+	extends System
+
+	var batch_calls := 0
+
+	func query():
+		return q.with_all([C_TestC])
+
+	func process_batch(entities: Array, columns: Dictionary, delta: float):
+		batch_calls += 1
+		var values: PackedInt64Array = columns.value
+		for i in values.size():
+			values[i] += 1
+		columns.value = values
+
+
+class SubSystemsSystem:
+	extends System
+
+	var order := []
+
+	func sub_systems():
+		return [
+			[ECS.world.get_query().with_all([C_TestC]), bump_c],
+			[ECS.world.get_query().with_all([C_TestB]), bump_b],
+		]
+
+	func bump_c(entity: Entity, delta: float):
+		order.append("c")
+		entity.get_component(C_TestC).value += 1
+
+	func bump_b(entity: Entity, delta: float):
+		order.append("b")
+		entity.get_component(C_TestB).value += 1
+
+
+class CommandSystem:
+	extends System
+
+	var seen_b := 0
+
+	func query():
+		return q.with_all([C_TestC])
+
+	func process(entity: Entity, delta: float):
+		cmd.add_component(entity, C_TestB.new())
+		cmd.remove_component(entity, C_TestC)
+		if entity.has_component(C_TestB):
+			seen_b += 1
+
+
+class TagSystem:
+	extends System
+
+	func query():
+		return q.with_all([C_TestA])
+
+	func process(entity: Entity, delta: float):
+		entity.add_component(C_TestD.new())
+
+
+class CountSystem:
+	extends System
+
+	var processed := 0
+
+	func query():
+		return q.with_all([C_TestD])
+
+	func process(entity: Entity, delta: float):
+		processed += 1
+
+
+class ChangedSystem:
+	extends System
+
+	var processed := []
+
+	func query():
+		return q.with_changed([C_TestC])
+
+	func process(entity: Entity, delta: float):
+		processed.append(entity)
+
+
+class AddedSystem:
+	extends System
+
+	var processed := []
+
+	func query():
+		return q.with_added([C_TestC])
+
+	func process(entity: Entity, delta: float):
+		processed.append(entity)
+
+
 func before():
 	runner = scene_runner("res://addons/gecs/tests/test_scene.tscn")
 	world = runner.get_property("world")
@@ -131,3 +228,200 @@ func test_system_group_processes_entities_with_required_components():
 
 	# Doesn't get incremented because no systems picked it up (still)
 	assert_int(entity_d.get_component(C_TestD).points).is_equal(0)
+
+
+func test_thread_safe_systems_match_serial_results():
+	# C_TestB writes and C_TestA reads don't conflict, so both systems share a wave
+	var sys_b = TestSystemB.new()
+	sys_b.thread_safe = true
+	sys_b.writes = [C_TestB]
+	var sys_perf = PerformanceTestSystem.new()
+	sys_perf.thread_safe = true
+	world.add_systems([sys_b, sys_perf])
+
+	var entities = []
+	for i in 50:
+		var entity = Entity.new()
+		entity.add_components([C_TestA.new(), C_TestB.new()])
+		entities.append(entity)
+	world.add_entities(entities)
+
+	world.multithreaded = true
+	world.process(0.1)
+	world.multithreaded = false
+	world.process(0.1)
+
+	assert_int(sys_perf.process_count).is_equal(100)
+	for entity in entities:
+		assert_int(entity.get_component(C_TestB).value).is_equal(2)
+
+
+func test_worker_structural_changes_land_before_the_next_wave():
+	var sys_tag = TagSystem.new()
+	sys_tag.thread_safe = true
+	sys_tag.writes = [C_TestD]
+	var sys_b = TestSystemB.new()
+	sys_b.thread_safe = true
+	sys_b.writes = [C_TestB]
+	# Not thread safe, so it runs in a later wave of the same frame
+	var sys_count = CountSystem.new()
+	world.add_systems([sys_tag, sys_b, sys_count])
+
+	for i in 10:
+		var entity = Entity.new()
+		entity.add_components([C_TestA.new(), C_TestB.new()])
+		world.add_entity(entity)
+
+	world.multithreaded = true
+	world.process(0.1)
+	world.multithreaded = false
+
+	assert_int(sys_count.processed).is_equal(10)
+
+
+func test_parallel_system_shares_a_wave_with_another_system():
+	var sys_b = TestSystemB.new()
+	sys_b.thread_safe = true
+	sys_b.parallel = true
+	sys_b.grain_size = 4
+	sys_b.writes = [C_TestB]
+	var sys_tag = TagSystem.new()
+	sys_tag.thread_safe = true
+	sys_tag.writes = [C_TestD]
+	world.add_systems([sys_b, sys_tag])
+
+	var entities = []
+	for i in 20:
+		var entity = Entity.new()
+		entity.add_components([C_TestA.new(), C_TestB.new()])
+		entities.append(entity)
+	world.add_entities(entities)
+
+	world.multithreaded = true
+	world.process(0.1)
+	world.multithreaded = false
+
+	for entity in entities:
+		assert_int(entity.get_component(C_TestB).value).is_equal(1)
+		assert_bool(entity.has_component(C_TestD)).is_true()
+
+
+func test_batch_system_writes_columns_back():
+	var sys = BatchSystem.new()
+	sys.grain_size = 4
+	sys.batch_columns = {"value": [C_TestC, "value"]}
+	sys.writes = [C_TestC]
+	world.add_system(sys)
+
+	var entities = []
+	for i in 10:
+		var entity = Entity.new()
+		entity.add_component(C_TestC.new(i))
+		entities.append(entity)
+	world.add_entities(entities)
+
+	world.process(0.1)
+
+	# 10 entities in chunks of 4 is three script calls instead of ten
+	assert_int(sys.batch_calls).is_equal(3)
+	for i in entities.size():
+		assert_int(entities[i].get_component(C_TestC).value).is_equal(i + 1)
+
+
+func test_sub_systems_run_in_order():
+	var sys = SubSystemsSystem.new()
+	world.add_system(sys)
+
+	var entity_c = Entity.new()
+	entity_c.add_component(C_TestC.new())
+	var entity_b = Entity.new()
+	entity_b.add_component(C_TestB.new())
+	world.add_entities([entity_c, entity_b])
+
+	world.process(0.1)
+	world.process(0.1)
+
+	assert_array(sys.order).is_equal(["c", "b", "c", "b"])
+	assert_int(entity_c.get_component(C_TestC).value).is_equal(2)
+	assert_int(entity_b.get_component(C_TestB).value).is_equal(2)
+
+
+func test_command_buffer_applies_after_system():
+	var sys = CommandSystem.new()
+	world.add_system(sys)
+
+	var entities = []
+	for i in 5:
+		var entity = Entity.new()
+		entity.add_component(C_TestC.new(i))
+		entities.append(entity)
+	world.add_entities(entities)
+
+	world.process(0.1)
+
+	# Nothing changed while the system iterated; everything landed at the flush
+	assert_int(sys.seen_b).is_equal(0)
+	assert_bool(sys.cmd.is_empty()).is_true()
+	for entity in entities:
+		assert_bool(entity.has_component(C_TestB)).is_true()
+		assert_bool(entity.has_component(C_TestC)).is_false()
+	assert_int(world.query.with_all([C_TestC]).execute().size()).is_equal(0)
+
+
+func test_command_buffer_batches_entity_adds_and_removes():
+	var buffer = CommandBuffer.new()
+	var entities = []
+	for i in 4:
+		var entity = Entity.new()
+		entity.add_component(C_TestC.new(i))
+		entities.append(entity)
+		buffer.add_entity(entity)
+	buffer.flush()
+	assert_int(world.query.with_all([C_TestC]).execute().size()).is_equal(4)
+
+	for entity in entities:
+		buffer.remove_entity(entity)
+	buffer.flush()
+	assert_int(world.query.with_all([C_TestC]).execute().size()).is_equal(0)
+
+
+func test_with_changed_only_returns_entities_touched_since_last_run():
+	var sys = ChangedSystem.new()
+	world.add_system(sys)
+
+	var entities = []
+	for i in 3:
+		var entity = Entity.new()
+		entity.add_component(C_TestC.new(i))
+		entities.append(entity)
+	world.add_entities(entities)
+
+	# Newly added components count as changed
+	world.process(0.1)
+	assert_int(sys.processed.size()).is_equal(3)
+
+	sys.processed.clear()
+	world.process(0.1)
+	assert_int(sys.processed.size()).is_equal(0)
+
+	var component = entities[1].get_component(C_TestC)
+	component.value = 10
+	component.emit_property_changed("value", 1, 10)
+	world.process(0.1)
+	assert_array(sys.processed).contains_exactly([entities[1]])
+
+
+func test_with_added_sees_components_added_while_disabled():
+	var sys = AddedSystem.new()
+	world.add_system(sys)
+
+	var entity = Entity.new()
+	world.add_entity(entity)
+	world.process(0.1)
+
+	world.disable_entity(entity)
+	entity.add_component(C_TestC.new())
+	world.enable_entity(entity)
+	world.process(0.1)
+
+	assert_array(sys.processed).contains_exactly([entity])
@@ -39,6 +39,85 @@ func test_add_and_remove_entity():
 	assert_bool(world.entities.has(entity)).is_false()
 
 
+func test_entity_handles():
+	var entity1 = Entity.new()
+	var entity2 = Entity.new()
+	world.add_entities([entity1, entity2])
+	var handle1 = entity1.get_handle()
+	assert_bool(world.is_entity_handle_valid(handle1)).is_true()
+	assert_object(world.get_entity(handle1)).is_same(entity1)
+	assert_int(world.get_entity_count()).is_equal(2)
+
+	world.remove_entity(entity1)
+	# The slot is reused, but the stale handle must not resolve to the new entity
+	var entity3 = Entity.new()
+	world.add_entity(entity3)
+	assert_bool(world.is_entity_handle_valid(handle1)).is_false()
+	assert_object(world.get_entity(handle1)).is_null()
+	assert_object(world.get_entity(entity3.get_handle())).is_same(entity3)
+	assert_bool(world.has_entity(entity2)).is_true()
+	assert_int(world.get_entity_count()).is_equal(2)
+
+
+func test_spawn_batch_and_remove_entities():
+	var template = Entity.new()
+	template.add_component(C_TestC.new(7))
+	var added := []
+	world.entities_added.connect(func(entities): added.append(entities.size()))
+
+	var spawned = world.spawn_batch(template, 100)
+	assert_int(spawned.size()).is_equal(100)
+	assert_array(added).is_equal([100])
+	assert_int(world.query.with_all([C_TestC]).execute().size()).is_equal(100)
+	# Every copy owns its components
+	spawned[0].get_component(C_TestC).value = 1
+	assert_int(spawned[1].get_component(C_TestC).value).is_equal(7)
+
+	world.remove_entities(spawned.slice(0, 60))
+	assert_int(world.get_entity_count()).is_equal(40)
+	assert_int(world.query.with_all([C_TestC]).execute().size()).is_equal(40)
+	template.free()
+
+
+func test_spawn_batch_from_initialized_template():
+	var template = Entity.new()
+	template.component_resources = [C_TestC.new(7)]
+	world.add_entity(template)
+	# A runtime edit on the template is what the copies should start from
+	template.get_component(C_TestC).value = 8
+
+	var spawned = world.spawn_batch(template, 3)
+	for entity in spawned:
+		assert_int(entity.get_component(C_TestC).value).is_equal(8)
+		assert_int(entity.component_resources.size()).is_equal(1)
+	assert_int(world.query.with_all([C_TestC]).execute().size()).is_equal(4)
+
+
+func test_cache_invalidated_reports_structural_causes():
+	var entity = Entity.new()
+	world.add_entity(entity)
+	assert_int(world.query.with_all([C_TestC]).execute().size()).is_equal(0)
+	var causes := []
+	world.cache_invalidated.connect(func(cause): causes.append(cause))
+
+	entity.add_component(C_TestC.new())
+	entity.get_component(C_TestC).value = 5
+	world.remove_entity(entity)
+	assert_array(causes).is_equal(["component_added", "entity_removed"])
+
+
+func test_virtual_entities_are_queryable_and_promotable():
+	var entity = Entity.new()
+	world.add_entity(entity, [C_TestC.new(3)], false)
+	assert_bool(entity.is_inside_tree()).is_false()
+	assert_bool(world.has_entity(entity)).is_true()
+	assert_array(world.query.with_all([C_TestC]).execute()).contains([entity])
+
+	world.promote_entity(entity)
+	assert_bool(entity.is_inside_tree()).is_true()
+	assert_int(entity.get_component(C_TestC).value).is_equal(3)
+
+
 func test_add_and_remove_system():
 	var system = System.new()
 	# Test adding
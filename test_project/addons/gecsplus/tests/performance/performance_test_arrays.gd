@@ -311,6 +311,48 @@ func test_array_operations_memory_efficiency():
 	)
 
 
+## Test the native set operations on object arrays, the shape query results take
+func test_gecs_object_set_operations():
+	for size in [10000, 100000]:
+		var array1: Array = []
+		var array2: Array = []
+		for i in size:
+			var item = RefCounted.new()
+			array1.append(item)
+			if i % 2 == 0:
+				array2.append(item)
+		for i in size / 2:
+			array2.append(RefCounted.new())
+
+		var intersect_test = func():
+			var result = GECS.intersect(array1, array2)
+			assert_that(result.size()).is_equal(size / 2)
+
+		var union_test = func():
+			var result = GECS.union_arrays(array1, array2)
+			assert_that(result.size()).is_equal(size + size / 2)
+
+		var difference_test = func():
+			var result = GECS.difference(array1, array2)
+			assert_that(result.size()).is_equal(size / 2)
+
+		benchmark("GECS_Intersect_Objects_%d" % size, intersect_test)
+		benchmark("GECS_Union_Objects_%d" % size, union_test)
+		benchmark("GECS_Difference_Objects_%d" % size, difference_test)
+
+	print_performance_results()
+
+	assert_performance_threshold(
+		"GECS_Intersect_Objects_100000", 100.0, "GECS.intersect too slow for 100k objects"
+	)
+	assert_performance_threshold(
+		"GECS_Union_Objects_100000", 150.0, "GECS.union_arrays too slow for 100k objects"
+	)
+	assert_performance_threshold(
+		"GECS_Difference_Objects_100000", 100.0, "GECS.difference too slow for 100k objects"
+	)
+
+
 ## Run all array performance tests
 func test_run_all_array_benchmarks():
 	test_array_intersect_small_scale()
@@ -354,6 +396,10 @@ func test_run_all_array_benchmarks():
 	before_test()
 
 	test_array_operations_memory_efficiency()
+	after_test()
+	before_test()
+
+	test_gecs_object_set_operations()
 
 	# Save results
 	save_performance_results("res://reports/array_performance_results.json")
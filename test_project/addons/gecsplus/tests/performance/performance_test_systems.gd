@@ -320,6 +320,36 @@ func test_inactive_system_performance():
 	)
 
 
+## Test chunked parallel iteration against the serial loop
+func test_parallel_system_processing():
+	setup_entities_for_systems(LARGE_SCALE)
+	var parallel_system = ParallelPerformanceTestSystem.new()
+	parallel_system.name = "ParallelPerformanceTestSystem"
+	parallel_system.grain_size = 256
+	test_world.add_system(parallel_system)
+
+	var process_systems = func(): test_world.process(0.016)
+
+	parallel_system.parallel = false
+	benchmark("Serial_System_Processing_Large_Scale", process_systems)
+	parallel_system.parallel = true
+	benchmark("Parallel_System_Processing_Large_Scale", process_systems)
+	parallel_system.deterministic = true
+	benchmark("Deterministic_Parallel_System_Processing_Large_Scale", process_systems)
+	print_performance_results()
+
+	# Each chunk only writes its own entities, so every entity saw every run
+	var runs = test_entities[0].get_component(C_TestA).value
+	assert_int(runs).is_greater(0)
+	for entity in test_entities:
+		assert_int(entity.get_component(C_TestA).value).is_equal(runs)
+	assert_performance_threshold(
+		"Parallel_System_Processing_Large_Scale",
+		150.0,
+		"Parallel system processing too slow at large scale"
+	)
+
+
 ## Run all system performance tests
 func test_run_all_system_benchmarks():
 	test_simple_system_processing_small_scale()
@@ -359,6 +389,10 @@ func test_run_all_system_benchmarks():
 	before_test()
 
 	test_inactive_system_performance()
+	after_test()
+	before_test()
+
+	test_parallel_system_processing()
 
 	# Save results
 	save_performance_results("res://reports/system_performance_results.json")
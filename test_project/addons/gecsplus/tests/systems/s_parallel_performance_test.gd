@@ -0,0 +1,22 @@
+## Thread-safe test system for chunked parallel benchmarking
+class_name ParallelPerformanceTestSystem
+extends System
+
+const C_TestA = preload("res://addons/gecs/tests/components/c_test_a.gd")
+
+
+func _init():
+	thread_safe = true
+	parallel = true
+	writes = [C_TestA]
+
+
+func query():
+	return q.with_all([C_TestA])
+
+
+func process(entity: Entity, delta: float) -> void:
+	# Only touches the entity's own component, so chunks can run concurrently
+	var component = entity.get_component(C_TestA)
+	if component:
+		component.value += 1